@@ -0,0 +1,183 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include <QHostAddress>
+#include <QJsonDocument>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include <algorithm>
+
+#include "fakeollamaserver.h"
+
+FakeOllamaServer::FakeOllamaServer(QObject *parent)
+    : QObject(parent)
+{
+    connect(&server_, &QTcpServer::newConnection, this, &FakeOllamaServer::handle_newConnection);
+}
+
+FakeOllamaServer::~FakeOllamaServer()
+{
+}
+
+bool FakeOllamaServer::listen()
+{
+    return server_.listen(QHostAddress::LocalHost);
+}
+
+QString FakeOllamaServer::getUrl() const
+{
+    return QStringLiteral("http://127.0.0.1:%1").arg(server_.serverPort());
+}
+
+void FakeOllamaServer::addScript(const QByteArray &path, const Script &script)
+{
+    scripts_[path].append(script);
+}
+
+QList<FakeOllamaServer::Request> FakeOllamaServer::getRequests() const
+{
+    return requests_;
+}
+
+int FakeOllamaServer::getRequestCount(const QByteArray &path) const
+{
+    return std::count_if(requests_.cbegin(), requests_.cend(), [&path](const Request &request) {
+        return request.path == path;
+    });
+}
+
+QByteArray FakeOllamaServer::record(const QJsonObject &json)
+{
+    return QJsonDocument(json).toJson(QJsonDocument::Compact) + '\n';
+}
+
+FakeOllamaServer::Script FakeOllamaServer::stream(const QList<QByteArray> &writes, int delayMs)
+{
+    Script script;
+    for (const QByteArray &data : writes) {
+        script.steps.append(Step{delayMs, data, false});
+    }
+    return script;
+}
+
+FakeOllamaServer::Script FakeOllamaServer::json(const QJsonObject &json, int status)
+{
+    Script script;
+    script.status = status;
+    script.contentType = "application/json";
+    script.chunked = false;
+    script.steps.append(Step{0, QJsonDocument(json).toJson(QJsonDocument::Compact), false});
+    return script;
+}
+
+void FakeOllamaServer::handle_newConnection()
+{
+    while (QTcpSocket *socket = server_.nextPendingConnection()) {
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+            handle_readyRead(socket);
+        });
+        // Pending steps of the socket are dropped with it.
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            buffers_.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void FakeOllamaServer::handle_readyRead(QTcpSocket *socket)
+{
+    QByteArray &buffer = buffers_[socket];
+    buffer.append(socket->readAll());
+
+    while (true) {
+        qsizetype headerEnd = buffer.indexOf("\r\n\r\n");
+        if (headerEnd < 0) {
+            return;
+        }
+
+        const QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+        const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+        if (requestLine.size() < 2) {
+            socket->disconnectFromHost();
+            return;
+        }
+
+        qsizetype contentLength = 0;
+        for (const QByteArray &line : lines) {
+            qsizetype colon = line.indexOf(':');
+            if (colon > 0 && line.left(colon).trimmed().toLower() == "content-length") {
+                contentLength = line.mid(colon + 1).trimmed().toLongLong();
+            }
+        }
+
+        qsizetype bodyStart = headerEnd + 4;
+        if (buffer.size() < bodyStart + contentLength) {
+            return;
+        }
+
+        Request request{requestLine.at(0), requestLine.at(1), buffer.mid(bodyStart, contentLength)};
+        buffer.remove(0, bodyStart + contentLength);
+        requests_.append(request);
+
+        QList<Script> &scripts = scripts_[request.path];
+        if (scripts.isEmpty()) {
+            runScript(socket, json(QJsonObject{{"error", "no script for " + QString::fromUtf8(request.path)}}, 404));
+        } else {
+            runScript(socket, scripts.size() > 1 ? scripts.takeFirst() : scripts.first());
+        }
+    }
+}
+
+void FakeOllamaServer::runScript(QTcpSocket *socket, const Script &script)
+{
+    QTimer::singleShot(script.headerDelayMs, socket, [this, socket, script]() {
+        QByteArray header = "HTTP/1.1 " + QByteArray::number(script.status) + (script.status < 400 ? " OK" : " Error") + "\r\n";
+        header += "Content-Type: " + script.contentType + "\r\n";
+        if (script.chunked) {
+            header += "Transfer-Encoding: chunked\r\n";
+        } else {
+            qsizetype contentLength = 0;
+            for (const Step &step : script.steps) {
+                contentLength += step.data.size();
+            }
+            header += "Content-Length: " + QByteArray::number(contentLength) + "\r\n";
+        }
+        socket->write(header + "\r\n");
+
+        runStep(socket, script, 0);
+    });
+}
+
+void FakeOllamaServer::runStep(QTcpSocket *socket, const Script &script, qsizetype index)
+{
+    if (index == script.steps.size()) {
+        if (script.chunked) {
+            socket->write("0\r\n\r\n");
+        }
+        return;
+    }
+
+    const Step &step = script.steps.at(index);
+    QTimer::singleShot(step.delayMs, socket, [this, socket, script, index]() {
+        const Step &step = script.steps.at(index);
+        if (step.close) {
+            socket->disconnectFromHost();
+            return;
+        }
+
+        if (!step.data.isEmpty()) {
+            if (script.chunked) {
+                socket->write(QByteArray::number(step.data.size(), 16) + "\r\n" + step.data + "\r\n");
+            } else {
+                socket->write(step.data);
+            }
+        }
+        socket->flush();
+
+        runStep(socket, script, index + 1);
+    });
+}
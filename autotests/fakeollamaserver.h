@@ -0,0 +1,85 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+#ifndef FAKEOLLAMASERVER_H
+#define FAKEOLLAMASERVER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QTcpServer>
+
+class QTcpSocket;
+
+/*
+ * A scriptable stand-in for Ollama on the loopback interface.
+ * Every request to a path is answered with the next script queued for it: a status, headers and a list of
+ * timed writes, which may split records anywhere, pause or drop the connection. Requests are recorded,
+ * so tests can check what OllamaSystem sent.
+ */
+class FakeOllamaServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Waits, then writes the data, or closes the connection.
+    struct Step {
+        int delayMs = 0;
+        QByteArray data;
+        bool close = false;
+    };
+
+    struct Script {
+        int status = 200;
+        QByteArray contentType = "application/x-ndjson";
+        // Streams are sent chunked like Ollama does, other responses with a Content-Length.
+        bool chunked = true;
+        int headerDelayMs = 0;
+        QList<Step> steps;
+    };
+
+    struct Request {
+        QByteArray method;
+        QByteArray path;
+        QByteArray body;
+    };
+
+    explicit FakeOllamaServer(QObject *parent = nullptr);
+    ~FakeOllamaServer();
+
+    // Starts listening on a free port of the loopback interface.
+    bool listen();
+    // Gets the url to send requests to, e.g. http://127.0.0.1:12345.
+    QString getUrl() const;
+
+    // Queues the script for the next request to the path. The last script of a path is used again when none are left.
+    void addScript(const QByteArray &path, const Script &script);
+    // Gets every request received so far, oldest first.
+    QList<Request> getRequests() const;
+    // Gets how many requests to the path were received.
+    int getRequestCount(const QByteArray &path) const;
+
+    // Gets a record as Ollama streams it: compact JSON and a newline.
+    static QByteArray record(const QJsonObject &json);
+    // Gets a script which streams the data in one write per step, each after the delay.
+    static Script stream(const QList<QByteArray> &writes, int delayMs = 0);
+    // Gets a script which answers with a single JSON document.
+    static Script json(const QJsonObject &json, int status = 200);
+
+private:
+    void handle_newConnection();
+    void handle_readyRead(QTcpSocket *socket);
+    void runScript(QTcpSocket *socket, const Script &script);
+    void runStep(QTcpSocket *socket, const Script &script, qsizetype index);
+
+    QTcpServer server_;
+    QHash<QByteArray, QList<Script>> scripts_;
+    QHash<QTcpSocket *, QByteArray> buffers_;
+    QList<Request> requests_;
+};
+
+#endif // FAKEOLLAMASERVER_H
@@ -0,0 +1,449 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTest>
+
+#include "fakeollamaserver.h"
+#include "src/ollama/ollamadata.h"
+#include "src/ollama/ollamarequest.h"
+#include "src/ollama/ollamaresponse.h"
+#include "src/ollama/ollamasystem.h"
+
+// Records the signals of a request in the order they were emitted, with the milliseconds since it was made.
+class SignalRecorder
+{
+public:
+    explicit SignalRecorder(OllamaRequest *request)
+    {
+        timer_.start();
+        QObject::connect(request, &OllamaRequest::signal_metaDataChanged, request, [this](OllamaResponse) {
+            record(QStringLiteral("metaData"));
+        });
+        QObject::connect(request, &OllamaRequest::signal_gotResponse, request, [this](OllamaResponse ollamaResponse) {
+            record(QStringLiteral("response:") + ollamaResponse.getResponseText());
+        });
+        QObject::connect(request, &OllamaRequest::signal_finished, request, [this](OllamaResponse ollamaResponse) {
+            record(QStringLiteral("finished"));
+            finalResponse = ollamaResponse;
+            finished = true;
+        });
+    }
+
+    bool waitForFinished(int timeoutMs = 5000)
+    {
+        return QTest::qWaitFor(
+            [this]() {
+                return finished;
+            },
+            timeoutMs);
+    }
+
+    QStringList events;
+    QList<qint64> times;
+    OllamaResponse finalResponse;
+    bool finished = false;
+
+private:
+    void record(const QString &event)
+    {
+        events.append(event);
+        times.append(timer_.elapsed());
+    }
+
+    QElapsedTimer timer_;
+};
+
+class OllamaSystemTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void fetchModelsSortsAndCaches();
+    void fetchModelsReportsErrors();
+    void streamsRecordsSplitAcrossWrites();
+    void streamsCoalescedRecords();
+    void readsNonStreamingResponse();
+    void sendsTypedRequestFields();
+    void reportsErrorRecordMidStream();
+    void reportsHttpErrorRecord();
+    void reportsDroppedConnection();
+    void deliversTokensAsTheyArrive();
+    void timesOutWithoutFirstToken();
+    void timesOutOnStall();
+    void retriesUnavailableServer();
+    void handlesLargePayloads();
+    void cancelsRunningRequest();
+
+private:
+    OllamaData createData() const;
+
+    FakeOllamaServer *server_ = nullptr;
+    OllamaSystem *ollamaSystem_ = nullptr;
+};
+
+static QByteArray token(const QString &text)
+{
+    return FakeOllamaServer::record(QJsonObject{{"model", "fake"}, {"response", text}, {"done", false}});
+}
+
+static QByteArray doneRecord()
+{
+    return FakeOllamaServer::record(QJsonObject{{"model", "fake"},
+                                                {"response", ""},
+                                                {"done", true},
+                                                {"done_reason", "stop"},
+                                                {"context", QJsonArray{1, 2, 3}},
+                                                {"total_duration", 5000000},
+                                                {"load_duration", 1000000},
+                                                {"prompt_eval_count", 4},
+                                                {"prompt_eval_duration", 2000000},
+                                                {"eval_count", 2},
+                                                {"eval_duration", 2000000}});
+}
+
+void OllamaSystemTest::initTestCase()
+{
+    // Keeps the disk tier of the response cache out of the user's cache directory.
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void OllamaSystemTest::init()
+{
+    server_ = new FakeOllamaServer(this);
+    QVERIFY(server_->listen());
+
+    ollamaSystem_ = new OllamaSystem(nullptr);
+    ollamaSystem_->setResponseCacheEnabled(false);
+}
+
+void OllamaSystemTest::cleanup()
+{
+    delete ollamaSystem_;
+    ollamaSystem_ = nullptr;
+    delete server_;
+    server_ = nullptr;
+}
+
+OllamaData OllamaSystemTest::createData() const
+{
+    OllamaData data;
+    data.setOllamaUrl(server_->getUrl());
+    data.setModel(QStringLiteral("fake"));
+    data.setSender(QStringLiteral("test"));
+    data.setPrompt(QStringLiteral("Say hello"));
+    return data;
+}
+
+void OllamaSystemTest::fetchModelsSortsAndCaches()
+{
+    server_->addScript("/api/tags", FakeOllamaServer::json(QJsonObject{{"models", QJsonArray{QJsonObject{{"name", "zeta"}}, QJsonObject{{"name", "Alpha"}}}}}));
+
+    QSignalSpy loadedSpy(ollamaSystem_, &OllamaSystem::signal_modelsListLoaded);
+    ollamaSystem_->fetchModels(createData());
+    QVERIFY(loadedSpy.wait());
+
+    QCOMPARE(loadedSpy.first().at(0).toString(), server_->getUrl());
+    const QList<QJsonValue> models = ollamaSystem_->getModels(server_->getUrl());
+    QCOMPARE(models.size(), qsizetype(2));
+    QCOMPARE(models.at(0).toObject().value("name").toString(), QStringLiteral("Alpha"));
+    QCOMPARE(models.at(1).toObject().value("name").toString(), QStringLiteral("zeta"));
+
+    // Within the TTL the cached list is used.
+    ollamaSystem_->fetchModels(createData());
+    QTest::qWait(100);
+    QCOMPARE(server_->getRequestCount("/api/tags"), 1);
+    QCOMPARE(loadedSpy.size(), qsizetype(1));
+}
+
+void OllamaSystemTest::fetchModelsReportsErrors()
+{
+    server_->addScript("/api/tags", FakeOllamaServer::json(QJsonObject{{"error", "boom"}}, 500));
+
+    QSignalSpy errorSpy(ollamaSystem_, &OllamaSystem::signal_errorFetchingModelsList);
+    ollamaSystem_->fetchModels(createData());
+    QVERIFY(errorSpy.wait());
+
+    QCOMPARE(errorSpy.first().at(0).toString(), server_->getUrl());
+    QVERIFY(ollamaSystem_->getModels(server_->getUrl()).isEmpty());
+}
+
+void OllamaSystemTest::streamsRecordsSplitAcrossWrites()
+{
+    QByteArray stream = token(QStringLiteral("Hel")) + token(QStringLiteral("lo")) + doneRecord();
+    // Cuts through the first record, the newline between the records and the final record.
+    qsizetype firstNewline = stream.indexOf('\n');
+    QList<QByteArray> writes{stream.left(5), stream.mid(5, firstNewline - 5), stream.mid(firstNewline, 20), stream.mid(firstNewline + 20)};
+    server_->addScript("/api/generate", FakeOllamaServer::stream(writes, 30));
+
+    SignalRecorder recorder(ollamaSystem_->ollamaRequest(createData()));
+    QVERIFY(recorder.waitForFinished());
+
+    QCOMPARE(recorder.events,
+             QStringList({QStringLiteral("metaData"), QStringLiteral("response:Hel"), QStringLiteral("response:lo"), QStringLiteral("finished")}));
+    QCOMPARE(recorder.finalResponse.getErrorType(), OllamaResponse::NoError);
+    QCOMPARE(recorder.finalResponse.getResponseText(), QStringLiteral("Hello"));
+    QVERIFY(recorder.finalResponse.isDone());
+    QCOMPARE(recorder.finalResponse.getDoneReason(), QStringLiteral("stop"));
+    QCOMPARE(recorder.finalResponse.getContext(), QList<qint64>({1, 2, 3}));
+    QCOMPARE(recorder.finalResponse.getEvalCount(), qint64(2));
+    QCOMPARE(recorder.finalResponse.getLoadDuration(), qint64(1000000));
+    QVERIFY(recorder.finalResponse.getTimeToFirstToken() >= 0);
+}
+
+void OllamaSystemTest::streamsCoalescedRecords()
+{
+    server_->addScript("/api/generate", FakeOllamaServer::stream({token(QStringLiteral("Hel")) + token(QStringLiteral("lo")) + doneRecord()}));
+
+    SignalRecorder recorder(ollamaSystem_->ollamaRequest(createData()));
+    QVERIFY(recorder.waitForFinished());
+
+    QCOMPARE(recorder.events,
+             QStringList({QStringLiteral("metaData"), QStringLiteral("response:Hel"), QStringLiteral("response:lo"), QStringLiteral("finished")}));
+    QCOMPARE(recorder.finalResponse.getResponseText(), QStringLiteral("Hello"));
+    QCOMPARE(recorder.finalResponse.getContext(), QList<qint64>({1, 2, 3}));
+}
+
+void OllamaSystemTest::readsNonStreamingResponse()
+{
+    // Without streaming Ollama sends a single document without a trailing newline.
+    server_->addScript("/api/generate", FakeOllamaServer::json(QJsonObject{{"model", "fake"}, {"response", "Hello"}, {"done", true}, {"done_reason", "stop"}}));
+
+    OllamaData data = createData();
+    data.setStream(false);
+    SignalRecorder recorder(ollamaSystem_->ollamaRequest(data));
+    QVERIFY(recorder.waitForFinished());
+
+    QCOMPARE(recorder.events, QStringList({QStringLiteral("metaData"), QStringLiteral("response:Hello"), QStringLiteral("finished")}));
+    QVERIFY(recorder.finalResponse.isDone());
+
+    QJsonObject sent = QJsonDocument::fromJson(server_->getRequests().last().body).object();
+    QVERIFY(sent.value("stream").isBool());
+    QCOMPARE(sent.value("stream").toBool(), false);
+}
+
+void OllamaSystemTest::sendsTypedRequestFields()
+{
+    server_->addScript("/api/generate", FakeOllamaServer::stream({doneRecord()}));
+
+    OllamaData data = createData();
+    data.setKeepAlive(QStringLiteral("300"));
+    data.setContext({7, 8, 9});
+    SignalRecorder numberRecorder(ollamaSystem_->ollamaRequest(data));
+    QVERIFY(numberRecorder.waitForFinished());
+
+    data.setKeepAlive(QStringLiteral("30m"));
+    data.setContext({});
+    SignalRecorder durationRecorder(ollamaSystem_->ollamaRequest(data));
+    QVERIFY(durationRecorder.waitForFinished());
+
+    const QList<FakeOllamaServer::Request> requests = server_->getRequests();
+    QCOMPARE(requests.size(), qsizetype(2));
+    QCOMPARE(requests.at(0).method, QByteArray("POST"));
+
+    QJsonObject first = QJsonDocument::fromJson(requests.at(0).body).object();
+    QCOMPARE(first.value("model").toString(), QStringLiteral("fake"));
+    QCOMPARE(first.value("prompt").toString(), QStringLiteral("Say hello"));
+    QVERIFY(first.value("stream").isBool());
+    QCOMPARE(first.value("stream").toBool(), true);
+    QVERIFY(first.value("keep_alive").isDouble());
+    QCOMPARE(first.value("keep_alive").toInteger(), qint64(300));
+    QVERIFY(first.value("context").isArray());
+    const QJsonArray context = first.value("context").toArray();
+    QCOMPARE(context.size(), qsizetype(3));
+    for (const QJsonValue &value : context) {
+        QVERIFY(value.isDouble());
+    }
+    QCOMPARE(context.at(2).toInteger(), qint64(9));
+
+    QJsonObject second = QJsonDocument::fromJson(requests.at(1).body).object();
+    QVERIFY(second.value("keep_alive").isString());
+    QCOMPARE(second.value("keep_alive").toString(), QStringLiteral("30m"));
+    QVERIFY(!second.contains("context"));
+}
+
+void OllamaSystemTest::reportsErrorRecordMidStream()
+{
+    server_->addScript("/api/generate",
+                       FakeOllamaServer::stream({token(QStringLiteral("Hel")), FakeOllamaServer::record(QJsonObject{{"error", "model crashed"}})}, 20));
+
+    SignalRecorder recorder(ollamaSystem_->ollamaRequest(createData()));
+    QVERIFY(recorder.waitForFinished());
+
+    QCOMPARE(recorder.events, QStringList({QStringLiteral("metaData"), QStringLiteral("response:Hel"), QStringLiteral("finished")}));
+    QCOMPARE(recorder.finalResponse.getErrorType(), OllamaResponse::ServerError);
+    QCOMPARE(recorder.finalResponse.getErrorMessage(), QStringLiteral("model crashed"));
+    QCOMPARE(recorder.finalResponse.getResponseText(), QStringLiteral("Hel"));
+    QVERIFY(!recorder.finalResponse.isDone());
+}
+
+void OllamaSystemTest::reportsHttpErrorRecord()
+{
+    server_->addScript("/api/generate", FakeOllamaServer::json(QJsonObject{{"error", "model 'fake' not found"}}, 404));
+
+    SignalRecorder recorder(ollamaSystem_->ollamaRequest(createData()));
+    QVERIFY(recorder.waitForFinished());
+
+    QCOMPARE(recorder.events.last(), QStringLiteral("finished"));
+    QVERIFY(!recorder.events.join(QLatin1Char('\n')).contains(QStringLiteral("response:")));
+    QCOMPARE(recorder.finalResponse.getErrorType(), OllamaResponse::ServerError);
+    QCOMPARE(recorder.finalResponse.getErrorMessage(), QStringLiteral("model 'fake' not found"));
+    // A missing model is not worth a retry.
+    QCOMPARE(server_->getRequestCount("/api/generate"), 1);
+}
+
+void OllamaSystemTest::reportsDroppedConnection()
+{
+    FakeOllamaServer::Script script = FakeOllamaServer::stream({token(QStringLiteral("Hel"))}, 20);
+    script.steps.append(FakeOllamaServer::Step{20, QByteArray(), true});
+    server_->addScript("/api/generate", script);
+
+    SignalRecorder recorder(ollamaSystem_->ollamaRequest(createData()));
+    QVERIFY(recorder.waitForFinished());
+
+    QCOMPARE(recorder.events, QStringList({QStringLiteral("metaData"), QStringLiteral("response:Hel"), QStringLiteral("finished")}));
+    QCOMPARE(recorder.finalResponse.getErrorType(), OllamaResponse::NetworkError);
+    QCOMPARE(recorder.finalResponse.getResponseText(), QStringLiteral("Hel"));
+    // Text was shown already, sending the request again would repeat it.
+    QCOMPARE(server_->getRequestCount("/api/generate"), 1);
+}
+
+void OllamaSystemTest::deliversTokensAsTheyArrive()
+{
+    server_->addScript("/api/generate",
+                       FakeOllamaServer::stream({token(QStringLiteral("a")), token(QStringLiteral("b")), token(QStringLiteral("c")), doneRecord()}, 150));
+
+    SignalRecorder recorder(ollamaSystem_->ollamaRequest(createData()));
+    QVERIFY(recorder.waitForFinished());
+
+    QCOMPARE(recorder.events,
+             QStringList({QStringLiteral("metaData"),
+                          QStringLiteral("response:a"),
+                          QStringLiteral("response:b"),
+                          QStringLiteral("response:c"),
+                          QStringLiteral("finished")}));
+    // Tokens are handed over as they arrive, not when the stream ends.
+    QVERIFY2(recorder.times.at(2) - recorder.times.at(1) >= 100, qPrintable(QString::number(recorder.times.at(2) - recorder.times.at(1))));
+    QVERIFY2(recorder.times.at(3) - recorder.times.at(2) >= 100, qPrintable(QString::number(recorder.times.at(3) - recorder.times.at(2))));
+    QVERIFY(recorder.times.at(1) < recorder.times.at(4) - 300);
+}
+
+void OllamaSystemTest::timesOutWithoutFirstToken()
+{
+    ollamaSystem_->setFirstTokenTimeout(200);
+    FakeOllamaServer::Script script = FakeOllamaServer::stream({token(QStringLiteral("late")), doneRecord()});
+    script.headerDelayMs = 3000;
+    server_->addScript("/api/generate", script);
+
+    QElapsedTimer timer;
+    timer.start();
+    SignalRecorder recorder(ollamaSystem_->ollamaRequest(createData()));
+    QVERIFY(recorder.waitForFinished());
+
+    QCOMPARE(recorder.events.last(), QStringLiteral("finished"));
+    QCOMPARE(recorder.finalResponse.getErrorType(), OllamaResponse::FirstTokenTimeoutError);
+    QVERIFY(recorder.finalResponse.getResponseText().isEmpty());
+    QVERIFY2(timer.elapsed() < 2000, qPrintable(QString::number(timer.elapsed())));
+    QCOMPARE(server_->getRequestCount("/api/generate"), 1);
+}
+
+void OllamaSystemTest::timesOutOnStall()
+{
+    ollamaSystem_->setStallTimeout(200);
+    FakeOllamaServer::Script script = FakeOllamaServer::stream({token(QStringLiteral("Hel"))});
+    script.steps.append(FakeOllamaServer::Step{3000, token(QStringLiteral("lo")), false});
+    server_->addScript("/api/generate", script);
+
+    QElapsedTimer timer;
+    timer.start();
+    SignalRecorder recorder(ollamaSystem_->ollamaRequest(createData()));
+    QVERIFY(recorder.waitForFinished());
+
+    QCOMPARE(recorder.events, QStringList({QStringLiteral("metaData"), QStringLiteral("response:Hel"), QStringLiteral("finished")}));
+    QCOMPARE(recorder.finalResponse.getErrorType(), OllamaResponse::StallTimeoutError);
+    QCOMPARE(recorder.finalResponse.getResponseText(), QStringLiteral("Hel"));
+    QVERIFY2(timer.elapsed() < 2000, qPrintable(QString::number(timer.elapsed())));
+}
+
+void OllamaSystemTest::retriesUnavailableServer()
+{
+    server_->addScript("/api/generate", FakeOllamaServer::json(QJsonObject{{"error", "server busy"}}, 503));
+    server_->addScript("/api/generate", FakeOllamaServer::stream({token(QStringLiteral("Hello")), doneRecord()}));
+
+    SignalRecorder recorder(ollamaSystem_->ollamaRequest(createData()));
+    QVERIFY(recorder.waitForFinished());
+
+    // The receiver only sees the attempt which worked.
+    QCOMPARE(recorder.events.mid(recorder.events.indexOf(QStringLiteral("response:Hello"))),
+             QStringList({QStringLiteral("response:Hello"), QStringLiteral("finished")}));
+    QCOMPARE(recorder.events.count(QStringLiteral("metaData")), qsizetype(1));
+    QCOMPARE(recorder.finalResponse.getErrorType(), OllamaResponse::NoError);
+    QCOMPARE(recorder.finalResponse.getResponseText(), QStringLiteral("Hello"));
+    QCOMPARE(server_->getRequestCount("/api/generate"), 2);
+}
+
+void OllamaSystemTest::handlesLargePayloads()
+{
+    const int tokens = 2000;
+    QByteArray stream;
+    for (int i = 0; i < tokens; ++i) {
+        stream += token(QStringLiteral("token "));
+    }
+    QString largeText(512 * 1024, QLatin1Char('y'));
+    stream += token(largeText);
+    stream += doneRecord();
+
+    // Writes of 64 KiB cut through records anywhere.
+    QList<QByteArray> writes;
+    for (qsizetype position = 0; position < stream.size(); position += 64 * 1024) {
+        writes.append(stream.mid(position, 64 * 1024));
+    }
+    server_->addScript("/api/generate", FakeOllamaServer::stream(writes));
+
+    OllamaData data = createData();
+    data.setPrompt(QString(1024 * 1024, QLatin1Char('x')));
+    SignalRecorder recorder(ollamaSystem_->ollamaRequest(data));
+    QVERIFY(recorder.waitForFinished(20000));
+
+    QCOMPARE(recorder.finalResponse.getErrorType(), OllamaResponse::NoError);
+    QCOMPARE(recorder.events.count(QStringLiteral("response:token ")), qsizetype(tokens));
+    QCOMPARE(recorder.finalResponse.getResponseText().size(), qsizetype(tokens) * 6 + largeText.size());
+    QVERIFY(recorder.finalResponse.getResponseText().endsWith(largeText));
+    QCOMPARE(QJsonDocument::fromJson(server_->getRequests().last().body).object().value("prompt").toString().size(), qsizetype(1024 * 1024));
+}
+
+void OllamaSystemTest::cancelsRunningRequest()
+{
+    FakeOllamaServer::Script script = FakeOllamaServer::stream({token(QStringLiteral("Hel"))});
+    script.steps.append(FakeOllamaServer::Step{3000, token(QStringLiteral("lo")) + doneRecord(), false});
+    server_->addScript("/api/generate", script);
+
+    OllamaRequest *request = ollamaSystem_->ollamaRequest(createData());
+    quint64 requestId = request->getId();
+    SignalRecorder recorder(request);
+    QObject::connect(request, &OllamaRequest::signal_gotResponse, request, [this, requestId](OllamaResponse) {
+        ollamaSystem_->cancelRequest(requestId);
+    });
+    QVERIFY(recorder.waitForFinished(2000));
+
+    QCOMPARE(recorder.events, QStringList({QStringLiteral("metaData"), QStringLiteral("response:Hel"), QStringLiteral("finished")}));
+    QCOMPARE(recorder.finalResponse.getErrorType(), OllamaResponse::CancelledError);
+    QCOMPARE(recorder.finalResponse.getResponseText(), QStringLiteral("Hel"));
+    QVERIFY(!ollamaSystem_->getRequest(requestId));
+}
+
+QTEST_GUILESS_MAIN(OllamaSystemTest)
+
+#include "ollamasystemtest.moc"
@@ -0,0 +1,206 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include <QHostAddress>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include <algorithm>
+#include <chrono>
+
+#include "mockollamaserver.h"
+
+MockOllamaServer::MockOllamaServer(QObject *parent)
+    : QObject(parent)
+{
+    connect(&server_, &QTcpServer::newConnection, this, &MockOllamaServer::handle_newConnection);
+}
+
+MockOllamaServer::~MockOllamaServer()
+{
+}
+
+bool MockOllamaServer::listen()
+{
+    return server_.listen(QHostAddress::LocalHost);
+}
+
+QString MockOllamaServer::getUrl() const
+{
+    return QStringLiteral("http://127.0.0.1:%1").arg(server_.serverPort());
+}
+
+void MockOllamaServer::setStreamOptions(const StreamOptions &streamOptions)
+{
+    streamOptions_ = streamOptions;
+}
+MockOllamaServer::StreamOptions MockOllamaServer::getStreamOptions() const
+{
+    return streamOptions_;
+}
+
+qint64 MockOllamaServer::getStreamBytes() const
+{
+    return streamBytes_;
+}
+void MockOllamaServer::resetStreamBytes()
+{
+    streamBytes_ = 0;
+}
+
+qint64 MockOllamaServer::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void MockOllamaServer::handle_newConnection()
+{
+    while (QTcpSocket *socket = server_.nextPendingConnection()) {
+        connections_.insert(socket, Connection());
+
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+            handle_readyRead(socket);
+        });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            connections_.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void MockOllamaServer::handle_readyRead(QTcpSocket *socket)
+{
+    Connection &connection = connections_[socket];
+    connection.buffer.append(socket->readAll());
+
+    // Requests are not pipelined, but a keep-alive connection sends the next one after the response.
+    while (true) {
+        qsizetype headerEnd = connection.buffer.indexOf("\r\n\r\n");
+        if (headerEnd < 0) {
+            return;
+        }
+
+        const QList<QByteArray> lines = connection.buffer.left(headerEnd).split('\n');
+        const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+        if (requestLine.size() < 2) {
+            socket->disconnectFromHost();
+            return;
+        }
+
+        qsizetype contentLength = 0;
+        for (const QByteArray &line : lines) {
+            qsizetype colon = line.indexOf(':');
+            if (colon > 0 && line.left(colon).trimmed().toLower() == "content-length") {
+                contentLength = line.mid(colon + 1).trimmed().toLongLong();
+            }
+        }
+
+        qsizetype bodyStart = headerEnd + 4;
+        if (connection.buffer.size() < bodyStart + contentLength) {
+            return;
+        }
+
+        QByteArray body = connection.buffer.mid(bodyStart, contentLength);
+        connection.buffer.remove(0, bodyStart + contentLength);
+
+        handleRequest(socket, requestLine.at(0), requestLine.at(1), body);
+    }
+}
+
+void MockOllamaServer::handleRequest(QTcpSocket *socket, const QByteArray &method, const QByteArray &path, const QByteArray &body)
+{
+    Q_UNUSED(method)
+
+    if (path == "/api/version") {
+        writeResponse(socket, "application/json", R"({"version":"0.0.0-mock"})");
+        return;
+    }
+    if (path == "/api/tags") {
+        writeResponse(socket, "application/json", R"({"models":[{"name":"mock:latest"}]})");
+        return;
+    }
+    if (path != "/api/generate" && path != "/api/chat") {
+        socket->write("HTTP/1.1 404 Not Found\r\nContent-Type: application/json\r\nContent-Length: 21\r\n\r\n{\"error\":\"not found\"}");
+        return;
+    }
+
+    Connection &connection = connections_[socket];
+    connection.chat = path == "/api/chat";
+    connection.tokensSent = 0;
+
+    QJsonObject json = QJsonDocument::fromJson(body).object();
+    if (!connection.chat && json.value(QLatin1String("prompt")).toString().isEmpty()) {
+        // A warm-up only loads the model.
+        writeResponse(socket, "application/json", R"({"model":"mock","response":"","done":true,"done_reason":"load"})");
+        return;
+    }
+
+    socket->write("HTTP/1.1 200 OK\r\nContent-Type: application/x-ndjson\r\nTransfer-Encoding: chunked\r\n\r\n");
+
+    if (streamOptions_.tokensPerSecond <= 0) {
+        while (connections_.contains(socket) && connections_[socket].tokensSent <= streamOptions_.tokens) {
+            writeStreamChunk(socket);
+        }
+        return;
+    }
+
+    if (!connection.timer) {
+        connection.timer = new QTimer(socket);
+        connect(connection.timer, &QTimer::timeout, this, [this, socket]() {
+            writeStreamChunk(socket);
+        });
+    }
+    connection.timer->start(std::max(1, 1000 * streamOptions_.tokensPerChunk / streamOptions_.tokensPerSecond));
+}
+
+void MockOllamaServer::writeResponse(QTcpSocket *socket, const QByteArray &contentType, const QByteArray &body)
+{
+    socket->write("HTTP/1.1 200 OK\r\nContent-Type: " + contentType + "\r\nContent-Length: " + QByteArray::number(body.size()) + "\r\n\r\n" + body);
+}
+
+void MockOllamaServer::writeStreamChunk(QTcpSocket *socket)
+{
+    Connection &connection = connections_[socket];
+
+    QByteArray data;
+    for (int i = 0; i < streamOptions_.tokensPerChunk && connection.tokensSent < streamOptions_.tokens; ++i, ++connection.tokensSent) {
+        // The text is the time the record was written, followed by a space like most tokens.
+        QByteArray text = QByteArray::number(now()) + ' ';
+        if (connection.chat) {
+            data += R"({"model":"mock","message":{"role":"assistant","content":")" + text + R"("},"done":false})" + '\n';
+        } else {
+            data += R"({"model":"mock","response":")" + text + R"(","done":false})" + '\n';
+        }
+    }
+
+    if (connection.tokensSent == streamOptions_.tokens) {
+        ++connection.tokensSent;
+        QByteArray stats = R"("total_duration":0,"load_duration":0,"prompt_eval_count":0,"prompt_eval_duration":0,"eval_count":)"
+            + QByteArray::number(streamOptions_.tokens) + R"(,"eval_duration":0)";
+        if (connection.chat) {
+            data += R"({"model":"mock","message":{"role":"assistant","content":""},"done":true,"done_reason":"stop",)" + stats + "}\n";
+        } else {
+            data += R"({"model":"mock","response":"","done":true,"done_reason":"stop","context":[1,2,3],)" + stats + "}\n";
+        }
+    }
+
+    writeChunk(socket, data);
+
+    if (connection.tokensSent > streamOptions_.tokens) {
+        socket->write("0\r\n\r\n");
+        if (connection.timer) {
+            connection.timer->stop();
+        }
+    }
+}
+
+void MockOllamaServer::writeChunk(QTcpSocket *socket, const QByteArray &data)
+{
+    streamBytes_ += data.size();
+    socket->write(QByteArray::number(data.size(), 16) + "\r\n" + data + "\r\n");
+}
@@ -0,0 +1,78 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+#ifndef MOCKOLLAMASERVER_H
+#define MOCKOLLAMASERVER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QTcpServer>
+
+class QTcpSocket;
+class QTimer;
+
+/*
+ * An in-process stand-in for Ollama which answers /api/generate and /api/chat with a synthetic NDJSON stream.
+ * Every streamed record carries the time it was written in its text, so the receiver can tell how long the
+ * client took to hand it over. Connections are kept alive like Ollama does.
+ */
+class MockOllamaServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    // The shape of the streams the server sends.
+    struct StreamOptions {
+        // Records of one token each before the final record.
+        int tokens = 1000;
+        // Tokens per second, 0 sends the whole stream at once.
+        int tokensPerSecond = 0;
+        // Records per write to the socket.
+        int tokensPerChunk = 1;
+    };
+
+    explicit MockOllamaServer(QObject *parent = nullptr);
+    ~MockOllamaServer();
+
+    // Starts listening on a free port of the loopback interface.
+    bool listen();
+    // Gets the url to send requests to, e.g. http://127.0.0.1:12345.
+    QString getUrl() const;
+
+    void setStreamOptions(const StreamOptions &streamOptions);
+    StreamOptions getStreamOptions() const;
+
+    // Gets the NDJSON bytes written for streams since the last reset, without HTTP framing.
+    qint64 getStreamBytes() const;
+    void resetStreamBytes();
+
+    // Gets the nanoseconds of the clock written into the records, to compare with.
+    static qint64 now();
+
+private:
+    // A request being read, or a response being streamed, on one connection.
+    struct Connection {
+        QByteArray buffer;
+        QTimer *timer = nullptr;
+        int tokensSent = 0;
+        bool chat = false;
+    };
+
+    void handle_newConnection();
+    void handle_readyRead(QTcpSocket *socket);
+    void handleRequest(QTcpSocket *socket, const QByteArray &method, const QByteArray &path, const QByteArray &body);
+    void writeResponse(QTcpSocket *socket, const QByteArray &contentType, const QByteArray &body);
+    // Writes the next chunk of the stream, and the final record after the last token.
+    void writeStreamChunk(QTcpSocket *socket);
+    void writeChunk(QTcpSocket *socket, const QByteArray &data);
+
+    QTcpServer server_;
+    StreamOptions streamOptions_;
+    QHash<QTcpSocket *, Connection> connections_;
+    qint64 streamBytes_ = 0;
+};
+
+#endif // MOCKOLLAMASERVER_H
@@ -0,0 +1,150 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+// Measures the client side of a streamed request: how long OllamaSystem takes to set a request up,
+// how fast it parses a stream and how long a token waits between arriving and reaching its receiver.
+// The server runs in the same process, so everything measured is spent in the plugin's code and Qt.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTextStream>
+
+#include <algorithm>
+#include <vector>
+
+#include "mockollamaserver.h"
+#include "src/ollama/ollamadata.h"
+#include "src/ollama/ollamarequest.h"
+#include "src/ollama/ollamaresponse.h"
+#include "src/ollama/ollamasystem.h"
+
+// Prints min, median, p95, p99 and max of the samples.
+static void printSummary(QTextStream &out, const QString &name, const QString &unit, std::vector<double> samples)
+{
+    if (samples.empty()) {
+        out << name << ": no samples\n";
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double p) {
+        return samples.at(std::min(samples.size() - 1, size_t(double(samples.size()) * p)));
+    };
+
+    out << qSetFieldWidth(24) << Qt::left << name << qSetFieldWidth(0) << Qt::right;
+    out << "min " << samples.front() << "  p50 " << percentile(0.5) << "  p95 " << percentile(0.95) << "  p99 " << percentile(0.99)
+        << "  max " << samples.back() << ' ' << unit << '\n';
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("ollamabenchmark"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Streams synthetic answers from an in-process mock Ollama server through OllamaSystem."));
+    parser.addHelpOption();
+    QCommandLineOption requestsOption(QStringLiteral("requests"), QStringLiteral("Requests to make, one after the other."), QStringLiteral("n"), QStringLiteral("20"));
+    QCommandLineOption tokensOption(QStringLiteral("tokens"), QStringLiteral("Tokens streamed per request."), QStringLiteral("n"), QStringLiteral("2000"));
+    QCommandLineOption rateOption(QStringLiteral("rate"), QStringLiteral("Tokens per second, 0 streams as fast as possible."), QStringLiteral("n"), QStringLiteral("0"));
+    QCommandLineOption chunkOption(QStringLiteral("chunk"), QStringLiteral("Records per write to the socket."), QStringLiteral("n"), QStringLiteral("1"));
+    QCommandLineOption promptSizeOption(QStringLiteral("prompt-size"), QStringLiteral("Characters in the prompt."), QStringLiteral("n"), QStringLiteral("4096"));
+    QCommandLineOption chatOption(QStringLiteral("chat"), QStringLiteral("Use /api/chat instead of /api/generate."));
+    parser.addOptions({requestsOption, tokensOption, rateOption, chunkOption, promptSizeOption, chatOption});
+    parser.process(app);
+
+    QTextStream out(stdout);
+
+    MockOllamaServer server;
+    MockOllamaServer::StreamOptions streamOptions;
+    streamOptions.tokens = std::max(1, parser.value(tokensOption).toInt());
+    streamOptions.tokensPerSecond = std::max(0, parser.value(rateOption).toInt());
+    streamOptions.tokensPerChunk = std::max(1, parser.value(chunkOption).toInt());
+    server.setStreamOptions(streamOptions);
+    if (!server.listen()) {
+        out << "Could not start the mock server\n";
+        return 1;
+    }
+
+    OllamaSystem ollamaSystem(nullptr);
+    ollamaSystem.setResponseCacheEnabled(false);
+    ollamaSystem.setStallTimeout(0);
+    ollamaSystem.setFirstTokenTimeout(0);
+
+    OllamaData data;
+    data.setOllamaUrl(server.getUrl());
+    data.setModel(QStringLiteral("mock"));
+    data.setSender(QStringLiteral("benchmark"));
+    data.setPrompt(QString(std::max(1, parser.value(promptSizeOption).toInt()), QLatin1Char('x')));
+    if (parser.isSet(chatOption)) {
+        data.setMessages({QJsonObject{{"role", "user"}, {"content", data.getPrompt()}}});
+    }
+
+    std::vector<double> setupUs;
+    std::vector<double> dispatchUs;
+    std::vector<double> throughputMBs;
+    std::vector<double> recordsPerSecond;
+
+    int requests = std::max(1, parser.value(requestsOption).toInt());
+    // The first request opens the connection, it is not counted.
+    for (int i = 0; i <= requests; ++i) {
+        server.resetStreamBytes();
+
+        QElapsedTimer timer;
+        timer.start();
+        OllamaRequest *request = ollamaSystem.ollamaRequest(data);
+        qint64 setupNs = timer.nsecsElapsed();
+
+        qint64 firstTokenNs = -1;
+        qint64 records = 0;
+        std::vector<double> requestDispatchUs;
+        requestDispatchUs.reserve(streamOptions.tokens);
+
+        QEventLoop loop;
+        QObject::connect(request, &OllamaRequest::signal_gotResponse, &loop, [&](OllamaResponse ollamaResponse) {
+            qint64 receivedNs = MockOllamaServer::now();
+            if (firstTokenNs < 0) {
+                firstTokenNs = timer.nsecsElapsed();
+            }
+            ++records;
+            requestDispatchUs.push_back(double(receivedNs - ollamaResponse.getResponseText().trimmed().toLongLong()) / 1000.0);
+        });
+        QObject::connect(request, &OllamaRequest::signal_finished, &loop, [&](OllamaResponse ollamaResponse) {
+            if (ollamaResponse.getErrorType() != OllamaResponse::NoError) {
+                out << "Request failed: " << ollamaResponse.getErrorMessage() << '\n';
+            }
+            loop.quit();
+        });
+        loop.exec();
+
+        if (i == 0) {
+            continue;
+        }
+
+        double streamSeconds = double(timer.nsecsElapsed() - firstTokenNs) / 1e9;
+        setupUs.push_back(double(setupNs) / 1000.0);
+        dispatchUs.insert(dispatchUs.end(), requestDispatchUs.begin(), requestDispatchUs.end());
+        if (firstTokenNs >= 0 && streamSeconds > 0) {
+            throughputMBs.push_back(double(server.getStreamBytes()) / streamSeconds / 1e6);
+            recordsPerSecond.push_back(double(records) / streamSeconds);
+        }
+    }
+
+    out << "requests " << requests << ", tokens " << streamOptions.tokens << ", rate " << streamOptions.tokensPerSecond << "/s, chunk "
+        << streamOptions.tokensPerChunk << ", prompt " << data.getPrompt().size() << " characters" << (parser.isSet(chatOption) ? ", chat" : "") << '\n';
+    printSummary(out, QStringLiteral("request setup"), QStringLiteral("us"), setupUs);
+    printSummary(out, QStringLiteral("token dispatch latency"), QStringLiteral("us"), dispatchUs);
+    printSummary(out, QStringLiteral("parse throughput"), QStringLiteral("MB/s"), throughputMBs);
+    printSummary(out, QStringLiteral("records"), QStringLiteral("/s"), recordsPerSecond);
+    if (streamOptions.tokensPerSecond > 0) {
+        out << "With a token rate the throughput is bounded by the server, use --rate 0 to measure the client.\n";
+    }
+
+    return 0;
+}
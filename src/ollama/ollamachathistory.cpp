@@ -0,0 +1,85 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include <QJsonObject>
+
+#include "src/ollama/ollamachathistory.h"
+#include "src/ollama/ollamatokenestimator.h"
+
+// Tokens the chat template adds around every message.
+static const int MessageOverheadTokens = 4;
+
+void OllamaChatHistory::addMessage(const QString &role, const QString &content)
+{
+    int tokens = OllamaTokenEstimator::estimateTokens(content) + MessageOverheadTokens;
+
+    messages_.append(Message{role, content, tokens});
+    tokenCount_ += tokens;
+}
+
+void OllamaChatHistory::removeLastMessage()
+{
+    if (messages_.isEmpty()) {
+        return;
+    }
+
+    tokenCount_ -= messages_.takeLast().tokens;
+}
+
+void OllamaChatHistory::clear()
+{
+    messages_.clear();
+    tokenCount_ = 0;
+}
+
+int OllamaChatHistory::size() const
+{
+    return messages_.size();
+}
+
+int OllamaChatHistory::getTokenCount() const
+{
+    return tokenCount_;
+}
+
+void OllamaChatHistory::trim(int tokenBudget)
+{
+    if (tokenCount_ <= tokenBudget) {
+        return;
+    }
+
+    int target = tokenBudget * 3 / 4;
+    qsizetype dropped = 0;
+
+    // The newest message (the question being asked) is always kept.
+    while (dropped < messages_.size() - 1 && tokenCount_ > target) {
+        tokenCount_ -= messages_.at(dropped).tokens;
+        ++dropped;
+    }
+
+    // Keep the history starting with a question, so roles keep alternating.
+    while (dropped < messages_.size() - 1 && messages_.at(dropped).role != QLatin1String("user")) {
+        tokenCount_ -= messages_.at(dropped).tokens;
+        ++dropped;
+    }
+
+    messages_.remove(0, dropped);
+}
+
+QJsonArray OllamaChatHistory::toJson(const QString &systemPrompt) const
+{
+    QJsonArray messagesArray;
+
+    if (!systemPrompt.isEmpty()) {
+        messagesArray.append(QJsonObject{{"role", "system"}, {"content", systemPrompt}});
+    }
+
+    for (const Message &message : messages_) {
+        messagesArray.append(QJsonObject{{"role", message.role}, {"content", message.content}});
+    }
+
+    return messagesArray;
+}
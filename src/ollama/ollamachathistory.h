@@ -0,0 +1,51 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+#ifndef OLLAMACHATHISTORY_H
+#define OLLAMACHATHISTORY_H
+
+#include <QJsonArray>
+#include <QList>
+#include <QString>
+
+/*
+ * The messages of one conversation, sent to /api/chat with every turn.
+ * Documentation: https://ollama.readthedocs.io/en/api/#generate-a-chat-completion
+ */
+class OllamaChatHistory
+{
+public:
+    // Appends a message with the given role: user or assistant.
+    void addMessage(const QString &role, const QString &content);
+    // Removes the newest message, e.g. a question whose answer failed.
+    void removeLastMessage();
+    // Removes all messages.
+    void clear();
+
+    // Gets the number of messages.
+    int size() const;
+    // Gets the estimated number of tokens of all messages.
+    int getTokenCount() const;
+
+    // Drops the oldest messages until the history fits in tokenBudget.
+    // It trims to three quarters of the budget at once, so the start of the conversation stays the same
+    // for several turns and Ollama can keep reusing its prompt cache for it.
+    void trim(int tokenBudget);
+
+    // Converts the system prompt and the messages to the messages array of a chat request.
+    QJsonArray toJson(const QString &systemPrompt) const;
+
+private:
+    struct Message {
+        QString role;
+        QString content;
+        int tokens;
+    };
+
+    QList<Message> messages_;
+    int tokenCount_ = 0;
+};
+
+#endif // OLLAMACHATHISTORY_H
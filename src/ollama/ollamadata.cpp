@@ -4,15 +4,20 @@
  *  SPDX-License-Identifier: LGPL-2.0-or-later
  */
 
+#include <QCryptographicHash>
 #include <QHashFunctions>
 #include <QJsonArray>
+#include <QJsonDocument>
 #include <QUrl>
 
 #include "src/ollama/ollamadata.h"
 
 OllamaData::OllamaData()
-    : context_(false)
-    , stream_(false)
+    : stream_(true)
+    , raw_(false)
+    , priority_(ChatPriority)
+    , cacheBypassed_(false)
+    , semanticCacheAllowed_(false)
 {
 }
 
@@ -56,6 +61,19 @@ QString OllamaData::getPrompt() const
     return prompt_;
 }
 
+void OllamaData::setMessages(const QJsonArray &messages)
+{
+    messages_ = messages;
+}
+QJsonArray OllamaData::getMessages() const
+{
+    return messages_;
+}
+bool OllamaData::isChat() const
+{
+    return !messages_.isEmpty();
+}
+
 void OllamaData::setSuffix(const QString &suffix)
 {
     suffix_ = suffix;
@@ -83,11 +101,11 @@ QString OllamaData::getFormat() const
     return format_;
 }
 
-void OllamaData::setOptions(const QString &options)
+void OllamaData::setOptions(const QJsonObject &options)
 {
     options_ = options;
 }
-QString OllamaData::getOptions() const
+QJsonObject OllamaData::getOptions() const
 {
     return options_;
 }
@@ -101,11 +119,11 @@ QString OllamaData::getSystemPrompt() const
     return system_;
 }
 
-void OllamaData::setContext(bool context)
+void OllamaData::setContext(const QList<qint64> &context)
 {
     context_ = context;
 }
-bool OllamaData::getContext() const
+QList<qint64> OllamaData::getContext() const
 {
     return context_;
 }
@@ -128,15 +146,42 @@ bool OllamaData::isRaw() const
     return raw_;
 }
 
-void OllamaData::setKeepAlive(bool keepAlive)
+void OllamaData::setKeepAlive(const QString &keepAlive)
 {
-    keepAlive_ = keepAlive;
+    keepAlive_ = keepAlive.trimmed();
 }
-bool OllamaData::isKeepAlive() const
+QString OllamaData::getKeepAlive() const
 {
     return keepAlive_;
 }
 
+void OllamaData::setPriority(Priority priority)
+{
+    priority_ = priority;
+}
+OllamaData::Priority OllamaData::getPriority() const
+{
+    return priority_;
+}
+
+void OllamaData::setCacheBypassed(bool cacheBypassed)
+{
+    cacheBypassed_ = cacheBypassed;
+}
+bool OllamaData::isCacheBypassed() const
+{
+    return cacheBypassed_;
+}
+
+void OllamaData::setSemanticCacheAllowed(bool semanticCacheAllowed)
+{
+    semanticCacheAllowed_ = semanticCacheAllowed;
+}
+bool OllamaData::isSemanticCacheAllowed() const
+{
+    return semanticCacheAllowed_;
+}
+
 QJsonObject OllamaData::toJson() const
 {
     QJsonObject json;
@@ -147,6 +192,9 @@ QJsonObject OllamaData::toJson() const
     if (!prompt_.isEmpty()) {
         json.insert("prompt", QJsonValue(prompt_));
     }
+    if (!messages_.isEmpty()) {
+        json.insert("messages", messages_);
+    }
     if (!suffix_.isEmpty()) {
         json.insert("suffix", QJsonValue(suffix_));
     }
@@ -154,22 +202,28 @@ QJsonObject OllamaData::toJson() const
         json.insert("format", QJsonValue(format_));
     }
     if (!options_.isEmpty()) {
-        json.insert("options", QJsonValue(options_));
+        json.insert("options", options_);
     }
     if (!system_.isEmpty()) {
         json.insert("system", QJsonValue(system_));
     }
-    if (context_) {
-        json.insert("context", QJsonValue(context_));
-    }
-    if (stream_) {
-        json.insert("stream", QJsonValue(stream_));
+    if (!context_.isEmpty()) {
+        QJsonArray contextArray;
+        for (qint64 token : context_) {
+            contextArray.append(QJsonValue(token));
+        }
+        json.insert("context", contextArray);
     }
+    // Sent either way, so the request does not depend on the server's default.
+    json.insert("stream", QJsonValue(stream_));
     if (raw_) {
         json.insert("raw", QJsonValue(raw_));
     }
-    if (keepAlive_) {
-        json.insert("keep_alive", QJsonValue(keepAlive_));
+    if (!keepAlive_.isEmpty()) {
+        // Ollama takes a number of seconds or a duration string, but not a number in a string.
+        bool isNumber = false;
+        qint64 seconds = keepAlive_.toLongLong(&isNumber);
+        json.insert("keep_alive", isNumber ? QJsonValue(seconds) : QJsonValue(keepAlive_));
     }
 
     QJsonArray imageArray;
@@ -183,6 +237,19 @@ QJsonObject OllamaData::toJson() const
     return json;
 }
 
+QByteArray OllamaData::getCacheKey() const
+{
+    QJsonObject json = toJson();
+    json.remove("keep_alive");
+
+    // QJsonObject keeps its keys sorted, so the compact form is canonical.
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(url_.toUtf8());
+    hash.addData(QJsonDocument(json).toJson(QJsonDocument::Compact));
+
+    return hash.result().toHex();
+}
+
 bool OllamaData::isOllamaUrlValid()
 {
     QUrl qUrl(url_);
@@ -6,7 +6,9 @@
 #ifndef OLLAMA_DATA_H
 #define OLLAMA_DATA_H
 
+#include <QJsonArray>
 #include <QJsonObject>
+#include <QList>
 #include <QString>
 #include <QVector>
 
@@ -17,6 +19,18 @@
 class OllamaData
 {
 public:
+    // How urgent a request is. Higher priorities are scheduled first and may preempt lower ones.
+    enum Priority {
+        // Batch work nobody is waiting for.
+        BackgroundPriority,
+        // Questions asked in a chat tab.
+        ChatPriority,
+        // Ghost text asked for at every typing pause. Scheduled ahead of chat questions, but only preempts background work.
+        CompletionPriority,
+        // Completions triggered from the editor.
+        InteractivePriority
+    };
+
     // Default constructor
     OllamaData();
 
@@ -43,6 +57,14 @@ public:
     // Gets the prompt to generate a response for
     QString getPrompt() const;
 
+    // Sets the messages of a conversation. A request with messages is sent to /api/chat instead of /api/generate.
+    // Documentation: https://ollama.readthedocs.io/en/api/#generate-a-chat-completion
+    void setMessages(const QJsonArray &messages);
+    // Gets the messages of a conversation. A request with messages is sent to /api/chat instead of /api/generate.
+    QJsonArray getMessages() const;
+    // Gets whether this is a request to /api/chat.
+    bool isChat() const;
+
     // Sets the text after the model response
     void setSuffix(const QString &suffix);
     // Gets the text after the model response
@@ -60,10 +82,10 @@ public:
 
     // Sets additional model parameters listed in the documentation for the Modelfile such as temperature
     // Documentation: https://ollama.readthedocs.io/en/modelfile/#valid-parameters-and-values
-    void setOptions(const QString &options);
+    void setOptions(const QJsonObject &options);
     // Gets additional model parameters listed in the documentation for the Modelfile such as temperature
     // Documentation: https://ollama.readthedocs.io/en/modelfile/#valid-parameters-and-values
-    QString getOptions() const;
+    QJsonObject getOptions() const;
 
     // Sets the system message (prompt) which is used.
     // Set this system message (prompt) to (overrides what is defined in the Modelfile)
@@ -73,14 +95,15 @@ public:
     QString getSystemPrompt() const;
 
     // Sets the context parameter returned from a previous request to /generate, this can be used to keep a short conversation
-    void setContext(bool context);
+    // Ollama then continues from the evaluated conversation instead of evaluating it again.
+    void setContext(const QList<qint64> &context);
     // Gets the context parameter returned from a previous request to /generate, this can be used to keep a short conversation
-    bool getContext() const;
+    QList<qint64> getContext() const;
 
-    // Sets the is stream setting.
+    // Sets the is stream setting. Default is true, like Ollama.
     // If false the response will be returned as a single response object, rather than a stream of objects
     void setStream(bool stream);
-    // Gets the is stream setting.
+    // Gets the is stream setting. Default is true, like Ollama.
     // If false the response will be returned as a single response object, rather than a stream of objects
     bool isStream() const;
 
@@ -91,13 +114,33 @@ public:
     // You may choose to use the raw parameter if you are specifying a full templated prompt in your request to the API
     bool isRaw() const;
 
-    // Sets the keep alive setting. Default is 5m when not set.
-    void setKeepAlive(bool keepAlive);
-    // Gets the keep alive setting. Default is 5m when not set.
-    bool isKeepAlive() const;
+    // Sets how long the model stays loaded after the request, e.g. 30m or 2h. A plain number is in seconds,
+    // -1 keeps it loaded and 0 unloads it right away. Ollama uses 5m when not set.
+    void setKeepAlive(const QString &keepAlive);
+    // Gets how long the model stays loaded after the request, e.g. 30m or 2h. Ollama uses 5m when not set.
+    QString getKeepAlive() const;
+
+    // Sets the priority used by the request scheduler of OllamaSystem. Default is ChatPriority.
+    void setPriority(Priority priority);
+    // Gets the priority used by the request scheduler of OllamaSystem. Default is ChatPriority.
+    Priority getPriority() const;
+
+    // Sets whether the response cache of OllamaSystem is skipped, so a fresh answer is generated (and cached). Default is false.
+    void setCacheBypassed(bool cacheBypassed);
+    // Gets whether the response cache of OllamaSystem is skipped, so a fresh answer is generated (and cached). Default is false.
+    bool isCacheBypassed() const;
+
+    // Sets whether the semantic cache of OllamaSystem may answer the prompt with the answer to a similar earlier prompt.
+    // Only free-standing questions qualify, not prompts which depend on text around them. Default is false.
+    void setSemanticCacheAllowed(bool semanticCacheAllowed);
+    // Gets whether the semantic cache of OllamaSystem may answer the prompt with the answer to a similar earlier prompt.
+    bool isSemanticCacheAllowed() const;
 
     // Converts all data, if filled, to a QJsonObject
     QJsonObject toJson() const;
+    // Gets a key which is the same for requests that ask the same endpoint for the same answer.
+    // Sender, priority and keep alive do not change the answer and are left out.
+    QByteArray getCacheKey() const;
 
     bool isOllamaUrlValid();
 
@@ -106,15 +149,19 @@ private:
     QString url_;
     QString model_;
     QString prompt_;
+    QJsonArray messages_;
     QString suffix_;
     QVector<QString> images_;
     QString format_;
-    QString options_;
+    QJsonObject options_;
     QString system_;
-    bool context_;
+    QList<qint64> context_;
     bool stream_;
     bool raw_;
-    bool keepAlive_;
+    QString keepAlive_;
+    Priority priority_;
+    bool cacheBypassed_;
+    bool semanticCacheAllowed_;
 };
 
 #endif // OLLAMA_DATA_H
@@ -0,0 +1,193 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QUrl>
+
+#include "src/ollama/ollamaendpointpool.h"
+
+static constexpr int HealthCheckIntervalMs = 30000;
+// A server which does not answer /api/version by then is treated as down.
+static constexpr int HealthCheckTimeoutMs = 3000;
+
+OllamaEndpointPool::OllamaEndpointPool(QNetworkAccessManager *networkManager, QObject *parent)
+    : QObject(parent)
+    , networkManager_(networkManager)
+{
+    healthTimer_.setInterval(HealthCheckIntervalMs);
+    connect(&healthTimer_, &QTimer::timeout, this, &OllamaEndpointPool::checkHealth);
+}
+
+OllamaEndpointPool::~OllamaEndpointPool()
+{
+}
+
+void OllamaEndpointPool::setEndpoints(const QStringList &urls)
+{
+    QList<Endpoint> endpoints;
+    for (const QString &url : urls) {
+        QString trimmedUrl = url.trimmed();
+        if (trimmedUrl.isEmpty() || !QUrl(trimmedUrl).isValid()) {
+            continue;
+        }
+        // Known endpoints keep their state, so a running check is not lost.
+        if (Endpoint *endpoint = findEndpoint(trimmedUrl)) {
+            endpoints.append(*endpoint);
+        } else {
+            Endpoint endpoint;
+            endpoint.url = trimmedUrl;
+            endpoints.append(endpoint);
+        }
+    }
+    endpoints_ = endpoints;
+
+    // A single endpoint has nothing to be balanced with.
+    if (endpoints_.size() > 1) {
+        healthTimer_.start();
+        checkHealth();
+    } else {
+        healthTimer_.stop();
+    }
+}
+
+QStringList OllamaEndpointPool::getEndpoints() const
+{
+    QStringList urls;
+    for (const Endpoint &endpoint : endpoints_) {
+        urls.append(endpoint.url);
+    }
+    return urls;
+}
+
+bool OllamaEndpointPool::contains(const QString &url) const
+{
+    return getEndpoints().contains(url);
+}
+
+bool OllamaEndpointPool::isHealthy(const QString &url) const
+{
+    for (const Endpoint &endpoint : endpoints_) {
+        if (endpoint.url == url) {
+            return endpoint.healthy;
+        }
+    }
+    return false;
+}
+
+QStringList OllamaEndpointPool::getAvailableEndpoints(const QString &model) const
+{
+    QString normalized = normalizedModel(model);
+
+    QStringList urls;
+    for (const Endpoint &endpoint : endpoints_) {
+        if (endpoint.healthy && (!endpoint.modelsKnown || endpoint.models.contains(normalized))) {
+            urls.append(endpoint.url);
+        }
+    }
+    return urls;
+}
+
+void OllamaEndpointPool::reportFailure(const QString &url)
+{
+    setHealthy(url, false);
+}
+
+void OllamaEndpointPool::checkHealth()
+{
+    for (Endpoint &endpoint : endpoints_) {
+        checkEndpoint(endpoint);
+    }
+}
+
+void OllamaEndpointPool::checkEndpoint(Endpoint &endpoint)
+{
+    if (endpoint.reply) {
+        return;
+    }
+
+    QNetworkRequest request(QUrl(endpoint.url + QStringLiteral("/api/version")));
+    request.setRawHeader("Connection", "keep-alive");
+    request.setTransferTimeout(HealthCheckTimeoutMs);
+
+    QNetworkReply *reply = networkManager_->get(request);
+    endpoint.reply = reply;
+
+    QString url = endpoint.url;
+    connect(reply, &QNetworkReply::finished, this, [this, reply, url]() {
+        reply->deleteLater();
+
+        Endpoint *endpoint = findEndpoint(url);
+        if (!endpoint || endpoint->reply != reply) {
+            return;
+        }
+        endpoint->reply = nullptr;
+
+        bool healthy = reply->error() == QNetworkReply::NoError;
+        if (!healthy) {
+            qWarning() << "Ollama endpoint" << url << "is down:" << reply->errorString();
+        }
+        setHealthy(url, healthy);
+        if (healthy) {
+            fetchEndpointModels(url);
+        }
+    });
+}
+
+void OllamaEndpointPool::fetchEndpointModels(const QString &url)
+{
+    QNetworkRequest request(QUrl(url + QStringLiteral("/api/tags")));
+    request.setRawHeader("Connection", "keep-alive");
+
+    QNetworkReply *reply = networkManager_->get(request);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, url]() {
+        reply->deleteLater();
+
+        Endpoint *endpoint = findEndpoint(url);
+        if (!endpoint || reply->error() != QNetworkReply::NoError) {
+            return;
+        }
+
+        QSet<QString> models;
+        const QJsonArray modelsArray = QJsonDocument::fromJson(reply->readAll()).object().value(QLatin1String("models")).toArray();
+        for (const QJsonValue &model : modelsArray) {
+            models.insert(normalizedModel(model.toObject().value(QLatin1String("name")).toString()));
+        }
+        endpoint->models = models;
+        endpoint->modelsKnown = true;
+    });
+}
+
+void OllamaEndpointPool::setHealthy(const QString &url, bool healthy)
+{
+    Endpoint *endpoint = findEndpoint(url);
+    if (!endpoint || endpoint->healthy == healthy) {
+        return;
+    }
+    endpoint->healthy = healthy;
+
+    emit signal_endpointHealthChanged(url, healthy);
+}
+
+OllamaEndpointPool::Endpoint *OllamaEndpointPool::findEndpoint(const QString &url)
+{
+    for (Endpoint &endpoint : endpoints_) {
+        if (endpoint.url == url) {
+            return &endpoint;
+        }
+    }
+    return nullptr;
+}
+
+QString OllamaEndpointPool::normalizedModel(const QString &model)
+{
+    return model.contains(QLatin1Char(':')) ? model : model + QStringLiteral(":latest");
+}
@@ -0,0 +1,72 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+#ifndef OLLAMAENDPOINTPOOL_H
+#define OLLAMAENDPOINTPOOL_H
+
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+class QNetworkAccessManager;
+class QNetworkReply;
+
+/*
+ * The Ollama servers requests may be spread over.
+ * Every endpoint is checked with /api/version and its models are listed with /api/tags, at start and then
+ * periodically, so requests only go to servers which are up and have the model.
+ */
+class OllamaEndpointPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    OllamaEndpointPool(QNetworkAccessManager *networkManager, QObject *parent = nullptr);
+    ~OllamaEndpointPool();
+
+    // Sets the endpoints of the pool and checks them right away.
+    void setEndpoints(const QStringList &urls);
+    // Gets the endpoints of the pool.
+    QStringList getEndpoints() const;
+    // Gets whether the url is an endpoint of the pool.
+    bool contains(const QString &url) const;
+    // Gets whether the endpoint answered the last health check. Endpoints count as healthy until checked.
+    bool isHealthy(const QString &url) const;
+    // Gets the healthy endpoints which have the model, or whose models are not known yet.
+    QStringList getAvailableEndpoints(const QString &model) const;
+
+    // Marks the endpoint as down after a request could not connect to it. The next health check may bring it back.
+    void reportFailure(const QString &url);
+    // Checks all endpoints now, instead of waiting for the next periodic check.
+    void checkHealth();
+
+signals:
+    void signal_endpointHealthChanged(const QString &url, bool healthy);
+
+private:
+    struct Endpoint {
+        QString url;
+        bool healthy = true;
+        bool modelsKnown = false;
+        QSet<QString> models;
+        QNetworkReply *reply = nullptr;
+    };
+
+    void checkEndpoint(Endpoint &endpoint);
+    void fetchEndpointModels(const QString &url);
+    void setHealthy(const QString &url, bool healthy);
+    Endpoint *findEndpoint(const QString &url);
+    // Ollama lists models with a tag, a model without one means :latest.
+    static QString normalizedModel(const QString &model);
+
+    QNetworkAccessManager *networkManager_;
+    QList<Endpoint> endpoints_;
+    QTimer healthTimer_;
+};
+
+#endif // OLLAMAENDPOINTPOOL_H
@@ -0,0 +1,38 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include "src/ollama/ollamarequest.h"
+
+OllamaRequest::OllamaRequest(quint64 id, const OllamaData &data, QObject *parent)
+    : QObject(parent)
+    , id_(id)
+    , data_(data)
+{
+    finalResponse_.setRequestId(id_);
+    finalResponse_.setReceiver(data_.getSender());
+    created_.start();
+    hedgeTimer_.setSingleShot(true);
+    watchdog_.setSingleShot(true);
+}
+
+OllamaRequest::~OllamaRequest()
+{
+}
+
+quint64 OllamaRequest::getId() const
+{
+    return id_;
+}
+
+OllamaData OllamaRequest::getData() const
+{
+    return data_;
+}
+
+OllamaResponse OllamaRequest::getResponse() const
+{
+    return finalResponse_;
+}
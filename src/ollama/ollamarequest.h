@@ -0,0 +1,87 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+#ifndef OLLAMAREQUEST_H
+#define OLLAMAREQUEST_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+#include <vector>
+
+#include "src/ollama/ollamadata.h"
+#include "src/ollama/ollamaresponse.h"
+#include "src/ollama/ollamastreamdecoder.h"
+
+class QNetworkReply;
+
+/*
+ * Handle to a single request made through OllamaSystem.
+ * Only the tab or view which made the request connects to its signals, so a streamed token
+ * wakes exactly one receiver. The handle is deleted by OllamaSystem after signal_finished.
+ */
+class OllamaRequest : public QObject
+{
+    Q_OBJECT
+
+public:
+    OllamaRequest(quint64 id, const OllamaData &data, QObject *parent = nullptr);
+    ~OllamaRequest();
+
+    // Gets the id which identifies this request within OllamaSystem.
+    quint64 getId() const;
+    // Gets the data the request was made with.
+    OllamaData getData() const;
+    // Gets the response collected so far, with all text streamed until now.
+    OllamaResponse getResponse() const;
+
+signals:
+    void signal_metaDataChanged(OllamaResponse ollamaResponse);
+    void signal_gotResponse(OllamaResponse ollamaResponse);
+    void signal_finished(OllamaResponse ollamaResponse);
+
+private:
+    // OllamaSystem drives the network side of the request.
+    friend class OllamaSystem;
+
+    quint64 id_;
+    OllamaData data_;
+    // Endpoint whose queue the request is scheduled on.
+    QString endpoint_;
+    QNetworkReply *reply_ = nullptr;
+    bool cancelled_ = false;
+    bool preempted_ = false;
+    // Set when the request is aborted to be started again later, before it produced any text.
+    bool requeued_ = false;
+    bool metaDataEmitted_ = false;
+    // Whether any text was emitted yet. Requests which streamed text can no longer be restarted.
+    bool streaming_ = false;
+    // Whether any part of the body arrived yet, from either reply.
+    bool receiving_ = false;
+    // How often the request was sent again after the connection failed.
+    int retries_ = 0;
+    // Runs from making the request, for the time to first token and the latency of its response.
+    QElapsedTimer created_;
+    // Runs from sending the request until the first part of the body.
+    QElapsedTimer sent_;
+    // A duplicate of the request on a second endpoint, sent when the first one is slow to answer.
+    // Whichever reply streams first is kept, the other one is aborted.
+    QNetworkReply *hedgeReply_ = nullptr;
+    QString hedgeEndpoint_;
+    QTimer hedgeTimer_;
+    // Aborts the reply when the server takes too long to connect, to send the first token or to send the next one.
+    QTimer watchdog_;
+    // The timeout the watchdog currently enforces, which becomes the error of the request when it fires.
+    OllamaResponse::ErrorType watchdogError_ = OllamaResponse::NoError;
+    // Set when the watchdog aborted the reply.
+    bool timedOut_ = false;
+    OllamaStreamDecoder decoder_;
+    OllamaResponse finalResponse_;
+    // Embedding of the prompt, when the semantic cache was asked. The answer is stored under it.
+    std::vector<float> embedding_;
+};
+
+#endif // OLLAMAREQUEST_H
@@ -1,6 +1,15 @@
 
 #include "src/ollama/ollamaresponse.h"
 
+void OllamaResponse::setRequestId(quint64 requestId)
+{
+    requestId_ = requestId;
+}
+quint64 OllamaResponse::getRequestId()
+{
+    return requestId_;
+}
+
 void OllamaResponse::setReceiver(QString receiver)
 {
     receiver_ = receiver;
@@ -18,6 +27,10 @@ QString OllamaResponse::getResponseText()
 {
     return responseText_;
 }
+void OllamaResponse::appendResponseText(const QString &responseText)
+{
+    responseText_.append(responseText);
+}
 
 void OllamaResponse::setErrorMessage(QString errorMessage)
 {
@@ -27,3 +40,120 @@ QString OllamaResponse::getErrorMessage()
 {
     return errorMessage_;
 }
+
+void OllamaResponse::setErrorType(ErrorType errorType)
+{
+    errorType_ = errorType;
+}
+OllamaResponse::ErrorType OllamaResponse::getErrorType()
+{
+    return errorType_;
+}
+
+void OllamaResponse::setDone(bool done)
+{
+    done_ = done;
+}
+bool OllamaResponse::isDone()
+{
+    return done_;
+}
+
+void OllamaResponse::setDoneReason(QString doneReason)
+{
+    doneReason_ = doneReason;
+}
+QString OllamaResponse::getDoneReason()
+{
+    return doneReason_;
+}
+
+void OllamaResponse::setContext(const QList<qint64> &context)
+{
+    context_ = context;
+}
+QList<qint64> OllamaResponse::getContext()
+{
+    return context_;
+}
+
+void OllamaResponse::setSimilarity(float similarity)
+{
+    similarity_ = similarity;
+}
+float OllamaResponse::getSimilarity()
+{
+    return similarity_;
+}
+
+void OllamaResponse::setTotalDuration(qint64 totalDuration)
+{
+    totalDuration_ = totalDuration;
+}
+qint64 OllamaResponse::getTotalDuration()
+{
+    return totalDuration_;
+}
+
+void OllamaResponse::setLoadDuration(qint64 loadDuration)
+{
+    loadDuration_ = loadDuration;
+}
+qint64 OllamaResponse::getLoadDuration()
+{
+    return loadDuration_;
+}
+
+void OllamaResponse::setPromptEvalCount(qint64 promptEvalCount)
+{
+    promptEvalCount_ = promptEvalCount;
+}
+qint64 OllamaResponse::getPromptEvalCount()
+{
+    return promptEvalCount_;
+}
+
+void OllamaResponse::setPromptEvalDuration(qint64 promptEvalDuration)
+{
+    promptEvalDuration_ = promptEvalDuration;
+}
+qint64 OllamaResponse::getPromptEvalDuration()
+{
+    return promptEvalDuration_;
+}
+
+void OllamaResponse::setEvalCount(qint64 evalCount)
+{
+    evalCount_ = evalCount;
+}
+qint64 OllamaResponse::getEvalCount()
+{
+    return evalCount_;
+}
+
+void OllamaResponse::setEvalDuration(qint64 evalDuration)
+{
+    evalDuration_ = evalDuration;
+}
+qint64 OllamaResponse::getEvalDuration()
+{
+    return evalDuration_;
+}
+
+void OllamaResponse::setTimeToFirstToken(qint64 timeToFirstToken)
+{
+    timeToFirstToken_ = timeToFirstToken;
+}
+qint64 OllamaResponse::getTimeToFirstToken()
+{
+    return timeToFirstToken_;
+}
+
+void OllamaResponse::setLatency(qint64 latency)
+{
+    latency_ = latency;
+}
+qint64 OllamaResponse::getLatency()
+{
+    return latency_;
+}
@@ -1,11 +1,36 @@
 #ifndef OLLAMARESPONSE_H
 #define OLLAMARESPONSE_H
 
+#include <QList>
 #include <QString>
 
 class OllamaResponse
 {
 public:
+    // Why a request did not complete normally.
+    enum ErrorType {
+        NoError,
+        // The connection failed or the server replied with an HTTP error.
+        NetworkError,
+        // Ollama reported an error in the stream.
+        ServerError,
+        // The request was cancelled by the user.
+        CancelledError,
+        // The request was stopped to make room for a request with a higher priority.
+        PreemptedError,
+        // The server could not be reached in time.
+        ConnectTimeoutError,
+        // The server took too long to send the first token, for example because loading the model hung.
+        FirstTokenTimeoutError,
+        // The server stopped sending tokens in the middle of the answer.
+        StallTimeoutError
+    };
+
+    // Sets the id of the request this response belongs to.
+    void setRequestId(quint64 requestId);
+    // Gets the id of the request this response belongs to.
+    quint64 getRequestId();
+
     // Sets the receiver. This can be used to control what to do with the data in the receiving UI.
     void setReceiver(QString receiver);
     // Gets the receiver. This can be used to control what to do with the data in the receiving UI.
@@ -15,16 +40,91 @@ public:
     void setResponseText(QString responseText);
     // Gets the response text.
     QString getResponseText();
+    // Appends to the response text. The response of signal_finished holds the whole text this way.
+    void appendResponseText(const QString &responseText);
 
     // Gets an error message when applicable.
     void setErrorMessage(QString errorMessage);
     // Sets an error message when applicable.
     QString getErrorMessage();
 
+    // Sets the kind of error when applicable.
+    void setErrorType(ErrorType errorType);
+    // Gets the kind of error when applicable.
+    ErrorType getErrorType();
+
+    // Sets whether Ollama sent the final record of the stream.
+    void setDone(bool done);
+    // Gets whether Ollama sent the final record of the stream.
+    bool isDone();
+
+    // Sets the reason Ollama gave for ending the response, e.g. stop or length.
+    void setDoneReason(QString doneReason);
+    // Gets the reason Ollama gave for ending the response, e.g. stop or length.
+    QString getDoneReason();
+
+    // Sets the context returned in the final record. Send it with the next request to continue the conversation.
+    void setContext(const QList<qint64> &context);
+    // Gets the context returned in the final record. Send it with the next request to continue the conversation.
+    QList<qint64> getContext();
+
+    // Sets how similar the question was to the earlier one whose answer the semantic cache replayed. 0 for generated answers.
+    void setSimilarity(float similarity);
+    // Gets how similar the question was to the earlier one whose answer the semantic cache replayed. 0 for generated answers.
+    float getSimilarity();
+
+    // Sets the time Ollama spent on the request in nanoseconds, from its final record.
+    void setTotalDuration(qint64 totalDuration);
+    // Gets the time Ollama spent on the request in nanoseconds, from its final record.
+    qint64 getTotalDuration();
+    // Sets the time Ollama spent loading the model in nanoseconds.
+    void setLoadDuration(qint64 loadDuration);
+    // Gets the time Ollama spent loading the model in nanoseconds.
+    qint64 getLoadDuration();
+    // Sets the number of prompt tokens Ollama evaluated. Tokens it had cached are not counted.
+    void setPromptEvalCount(qint64 promptEvalCount);
+    // Gets the number of prompt tokens Ollama evaluated. Tokens it had cached are not counted.
+    qint64 getPromptEvalCount();
+    // Sets the time Ollama spent evaluating the prompt in nanoseconds.
+    void setPromptEvalDuration(qint64 promptEvalDuration);
+    // Gets the time Ollama spent evaluating the prompt in nanoseconds.
+    qint64 getPromptEvalDuration();
+    // Sets the number of tokens Ollama generated.
+    void setEvalCount(qint64 evalCount);
+    // Gets the number of tokens Ollama generated.
+    qint64 getEvalCount();
+    // Sets the time Ollama spent generating tokens in nanoseconds.
+    void setEvalDuration(qint64 evalDuration);
+    // Gets the time Ollama spent generating tokens in nanoseconds.
+    qint64 getEvalDuration();
+
+    // Sets the milliseconds from making the request until its first text arrived, queueing included. -1 when there was no text.
+    void setTimeToFirstToken(qint64 timeToFirstToken);
+    // Gets the milliseconds from making the request until its first text arrived, queueing included. -1 when there was no text.
+    qint64 getTimeToFirstToken();
+    // Sets the milliseconds from making the request until it finished.
+    void setLatency(qint64 latency);
+    // Gets the milliseconds from making the request until it finished.
+    qint64 getLatency();
+
 private:
+    quint64 requestId_ = 0;
     QString receiver_;
     QString responseText_;
     QString errorMessage_;
+    ErrorType errorType_ = NoError;
+    bool done_ = false;
+    QString doneReason_;
+    QList<qint64> context_;
+    float similarity_ = 0;
+    qint64 totalDuration_ = 0;
+    qint64 loadDuration_ = 0;
+    qint64 promptEvalCount_ = 0;
+    qint64 promptEvalDuration_ = 0;
+    qint64 evalCount_ = 0;
+    qint64 evalDuration_ = 0;
+    qint64 timeToFirstToken_ = -1;
+    qint64 latency_ = 0;
 };
 
 #endif // OLLAMARESPONSE_H
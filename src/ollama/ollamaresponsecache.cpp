@@ -0,0 +1,133 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include "src/ollama/ollamaresponsecache.h"
+
+// Memory tier, in characters of response text.
+static constexpr int MaxMemoryCost = 4 * 1024 * 1024;
+// Disk tier, in answers. Checked every PruneInterval inserts.
+static constexpr int MaxDiskEntries = 4096;
+static constexpr int PruneInterval = 64;
+
+OllamaResponseCache::OllamaResponseCache()
+    : memory_(MaxMemoryCost)
+    , directory_(QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/kateollama/responses"))
+{
+}
+
+OllamaResponseCache::~OllamaResponseCache()
+{
+}
+
+bool OllamaResponseCache::isCacheable(const OllamaData &data)
+{
+    QJsonObject options = data.getOptions();
+
+    return options.contains(QLatin1String("seed"))
+        || (options.contains(QLatin1String("temperature")) && options.value(QLatin1String("temperature")).toDouble() == 0.0);
+}
+
+bool OllamaResponseCache::find(const QByteArray &key, OllamaResponse *response)
+{
+    const Entry *entry = memory_.object(key);
+    Entry diskEntry;
+
+    if (!entry) {
+        QFile file(getFilePath(key));
+        if (!file.open(QIODevice::ReadOnly)) {
+            return false;
+        }
+
+        QJsonObject json = QJsonDocument::fromJson(file.readAll()).object();
+        if (!json.contains(QLatin1String("response"))) {
+            return false;
+        }
+
+        diskEntry.responseText = json.value(QLatin1String("response")).toString();
+        diskEntry.doneReason = json.value(QLatin1String("done_reason")).toString();
+        const QJsonArray contextArray = json.value(QLatin1String("context")).toArray();
+        diskEntry.context.reserve(contextArray.size());
+        for (const QJsonValue &token : contextArray) {
+            diskEntry.context.append(token.toInteger());
+        }
+        // The answer is the entry read from disk, QCache drops a copy larger than its whole capacity right away.
+        memory_.insert(key, new Entry(diskEntry), qMax<qsizetype>(1, diskEntry.responseText.size()));
+        entry = &diskEntry;
+
+        // The modification time orders the files for pruning, so a hit counts as a use.
+        file.close();
+        file.open(QIODevice::ReadWrite);
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    }
+
+    response->setResponseText(entry->responseText);
+    response->setDone(true);
+    response->setDoneReason(entry->doneReason);
+    response->setContext(entry->context);
+
+    return true;
+}
+
+void OllamaResponseCache::insert(const QByteArray &key, OllamaResponse response)
+{
+    Entry *entry = new Entry;
+    entry->responseText = response.getResponseText();
+    entry->doneReason = response.getDoneReason();
+    entry->context = response.getContext();
+
+    QJsonArray contextArray;
+    for (qint64 token : std::as_const(entry->context)) {
+        contextArray.append(QJsonValue(token));
+    }
+    QJsonObject json{{"response", entry->responseText}, {"done_reason", entry->doneReason}, {"context", contextArray}};
+
+    memory_.insert(key, entry, qMax<qsizetype>(1, entry->responseText.size()));
+
+    if (!QDir().mkpath(directory_)) {
+        return;
+    }
+    QSaveFile file(getFilePath(key));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Error opening response cache file:" << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument(json).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        qWarning() << "Error writing response cache file:" << file.errorString();
+    }
+
+    if (++insertsSincePrune_ >= PruneInterval) {
+        insertsSincePrune_ = 0;
+        pruneDisk();
+    }
+}
+
+QString OllamaResponseCache::getFilePath(const QByteArray &key) const
+{
+    return directory_ + QLatin1Char('/') + QString::fromLatin1(key) + QStringLiteral(".json");
+}
+
+void OllamaResponseCache::pruneDisk()
+{
+    QDir dir(directory_);
+    QFileInfoList files = dir.entryInfoList({QStringLiteral("*.json")}, QDir::Files, QDir::Time | QDir::Reversed);
+
+    // Oldest first, because of QDir::Reversed.
+    for (qsizetype i = 0; i < files.size() - MaxDiskEntries; ++i) {
+        QFile::remove(files.at(i).absoluteFilePath());
+    }
+}
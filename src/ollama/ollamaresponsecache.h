@@ -0,0 +1,53 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+#ifndef OLLAMARESPONSECACHE_H
+#define OLLAMARESPONSECACHE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QList>
+#include <QString>
+
+#include "src/ollama/ollamadata.h"
+#include "src/ollama/ollamaresponse.h"
+
+/*
+ * Answers of earlier requests by OllamaData::getCacheKey().
+ * Recently used answers are kept in memory, all of them are kept on disk under the XDG cache directory,
+ * so the same question with the same model and system prompt does not go to the GPU again, not even after a restart.
+ * Only answers to deterministic requests are cached, otherwise asking again is how the user gets a different answer.
+ */
+class OllamaResponseCache
+{
+public:
+    OllamaResponseCache();
+    ~OllamaResponseCache();
+
+    // Whether the answer to the data is the same every time, because the seed or a zero temperature is set in its options.
+    static bool isCacheable(const OllamaData &data);
+
+    // Looks the answer up in memory and then on disk. Returns false when it was not cached.
+    bool find(const QByteArray &key, OllamaResponse *response);
+    // Stores a complete answer in memory and on disk.
+    void insert(const QByteArray &key, OllamaResponse response);
+
+private:
+    struct Entry {
+        QString responseText;
+        QString doneReason;
+        QList<qint64> context;
+    };
+
+    QString getFilePath(const QByteArray &key) const;
+    // Removes the least recently used files when the disk tier grew too large.
+    void pruneDisk();
+
+    QCache<QByteArray, Entry> memory_;
+    QString directory_;
+    int insertsSincePrune_ = 0;
+};
+
+#endif // OLLAMARESPONSECACHE_H
@@ -0,0 +1,299 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+#include <QSet>
+
+#include <algorithm>
+#include <cmath>
+
+#include "src/ollama/ollamasearchindex.h"
+
+// The usual BM25 parameters: term frequency saturation and length normalization.
+static constexpr float K1 = 1.2f;
+static constexpr float B = 0.75f;
+
+// Identifies a saved index, the version changes whenever its layout does.
+static constexpr quint32 FileMagic = 0x4b4f5349;
+static constexpr quint32 FileVersion = 1;
+
+OllamaSearchIndex::OllamaSearchIndex(OllamaSessionStore *sessionStore, QObject *parent)
+    : QObject(parent)
+    , sessionStore_(sessionStore)
+    , filePath_(sessionStore->getDirectory() + QStringLiteral("/search.idx"))
+    , openedLogSize_(sessionStore->getLogSize())
+{
+    connect(sessionStore_, &OllamaSessionStore::signal_turnAppended, this, &OllamaSearchIndex::handle_turnAppended);
+}
+
+OllamaSearchIndex::~OllamaSearchIndex()
+{
+    if (modified_) {
+        save();
+    }
+}
+
+QList<OllamaSearchIndex::Hit> OllamaSearchIndex::search(const QString &query, int maxHits)
+{
+    build();
+
+    const QList<QString> terms = tokenize(query);
+    if (terms.isEmpty() || documents_.empty()) {
+        return {};
+    }
+
+    float averageLength = float(totalLength_) / documents_.size();
+    std::vector<float> scores(documents_.size(), 0.0f);
+
+    QSet<quint32> seenTerms;
+    for (const QString &term : terms) {
+        auto termId = termIds_.constFind(term);
+        if (termId == termIds_.constEnd() || seenTerms.contains(*termId)) {
+            continue;
+        }
+        seenTerms.insert(*termId);
+
+        const std::vector<Posting> &postings = postings_[*termId];
+        float documentFrequency = postings.size();
+        float idf = std::log(1.0f + (documents_.size() - documentFrequency + 0.5f) / (documentFrequency + 0.5f));
+        for (const Posting &posting : postings) {
+            float termFrequency = posting.termFrequency;
+            float lengthRatio = documents_[posting.document].length / averageLength;
+            scores[posting.document] += idf * termFrequency * (K1 + 1) / (termFrequency + K1 * (1 - B + B * lengthRatio));
+        }
+    }
+
+    // A session ranks by its best turn.
+    QHash<quint32, float> sessionScores;
+    for (size_t document = 0; document < scores.size(); ++document) {
+        if (scores[document] > 0) {
+            float &sessionScore = sessionScores[documents_[document].session];
+            sessionScore = std::max(sessionScore, scores[document]);
+        }
+    }
+
+    QList<Hit> hits;
+    hits.reserve(sessionScores.size());
+    for (auto it = sessionScores.cbegin(); it != sessionScores.cend(); ++it) {
+        QUuid sessionId = sessionIds_.at(it.key());
+        if (!sessionStore_->getSession(sessionId).id.isNull()) {
+            hits.append({sessionId, it.value()});
+        }
+    }
+
+    auto byScore = [](const Hit &a, const Hit &b) {
+        return a.score > b.score;
+    };
+    if (hits.size() > maxHits) {
+        std::partial_sort(hits.begin(), hits.begin() + maxHits, hits.end(), byScore);
+        hits.resize(maxHits);
+    } else {
+        std::sort(hits.begin(), hits.end(), byScore);
+    }
+    return hits;
+}
+
+QList<QString> OllamaSearchIndex::tokenize(QStringView text)
+{
+    QList<QString> tokens;
+
+    qsizetype start = -1;
+    for (qsizetype i = 0; i <= text.size(); ++i) {
+        bool wordCharacter = i < text.size() && text.at(i).isLetterOrNumber();
+        if (wordCharacter && start == -1) {
+            start = i;
+        } else if (!wordCharacter && start != -1) {
+            // Single characters are too common to tell anything apart.
+            if (i - start > 1) {
+                tokens.append(text.sliced(start, i - start).toString().toLower());
+            }
+            start = -1;
+        }
+    }
+    return tokens;
+}
+
+void OllamaSearchIndex::handle_turnAppended(const QUuid &sessionId, const OllamaSessionStore::Turn &turn)
+{
+    // Before the first search the turn is read with all others.
+    if (built_) {
+        addDocument(sessionId, turn);
+        indexedLogSize_ = sessionStore_->getLogSize();
+        modified_ = true;
+    }
+}
+
+void OllamaSearchIndex::build()
+{
+    if (built_) {
+        return;
+    }
+    built_ = true;
+
+    if (!load()) {
+        clear();
+    }
+
+    // Only the turns appended since the postings were saved are read from the log.
+    qint64 logSize = sessionStore_->getLogSize();
+    if (indexedLogSize_ < logSize) {
+        sessionStore_->forEachTurn(
+            [this](const QUuid &sessionId, const OllamaSessionStore::Turn &turn) {
+                addDocument(sessionId, turn);
+            },
+            indexedLogSize_);
+        indexedLogSize_ = logSize;
+        save();
+    }
+}
+
+bool OllamaSearchIndex::load()
+{
+    QFile file(filePath_);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version >> indexedLogSize_ >> totalLength_;
+    if (magic != FileMagic || version != FileVersion || indexedLogSize_ > openedLogSize_) {
+        return false;
+    }
+
+    quint32 sessionCount = 0;
+    stream >> sessionCount;
+    for (quint32 i = 0; i < sessionCount && stream.status() == QDataStream::Ok; ++i) {
+        QUuid sessionId;
+        stream >> sessionId;
+        sessionNumbers_.insert(sessionId, sessionIds_.size());
+        sessionIds_.append(sessionId);
+    }
+
+    quint32 documentCount = 0;
+    stream >> documentCount;
+    for (quint32 i = 0; i < documentCount && stream.status() == QDataStream::Ok; ++i) {
+        Document document;
+        stream >> document.session >> document.length;
+        if (document.session >= quint32(sessionIds_.size())) {
+            stream.setStatus(QDataStream::ReadCorruptData);
+        }
+        documents_.push_back(document);
+    }
+
+    quint32 termCount = 0;
+    stream >> termCount;
+    for (quint32 termId = 0; termId < termCount && stream.status() == QDataStream::Ok; ++termId) {
+        QString term;
+        quint32 postingCount = 0;
+        stream >> term >> postingCount;
+        termIds_.insert(term, termId);
+
+        std::vector<Posting> &postings = postings_.emplace_back();
+        for (quint32 i = 0; i < postingCount && stream.status() == QDataStream::Ok; ++i) {
+            Posting posting;
+            stream >> posting.document >> posting.termFrequency;
+            if (posting.document >= documents_.size()) {
+                stream.setStatus(QDataStream::ReadCorruptData);
+            }
+            postings.push_back(posting);
+        }
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        qWarning() << "Error reading search index:" << filePath_;
+        return false;
+    }
+    return true;
+}
+
+void OllamaSearchIndex::save()
+{
+    QSaveFile file(filePath_);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Error saving search index:" << file.errorString();
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream << FileMagic << FileVersion << indexedLogSize_ << totalLength_;
+
+    stream << quint32(sessionIds_.size());
+    for (const QUuid &sessionId : std::as_const(sessionIds_)) {
+        stream << sessionId;
+    }
+
+    stream << quint32(documents_.size());
+    for (const Document &document : documents_) {
+        stream << document.session << document.length;
+    }
+
+    std::vector<QString> terms(postings_.size());
+    for (auto it = termIds_.cbegin(); it != termIds_.cend(); ++it) {
+        terms[it.value()] = it.key();
+    }
+    stream << quint32(postings_.size());
+    for (size_t termId = 0; termId < postings_.size(); ++termId) {
+        stream << terms[termId] << quint32(postings_[termId].size());
+        for (const Posting &posting : postings_[termId]) {
+            stream << posting.document << posting.termFrequency;
+        }
+    }
+
+    if (!file.commit()) {
+        qWarning() << "Error saving search index:" << file.errorString();
+        return;
+    }
+    modified_ = false;
+}
+
+void OllamaSearchIndex::clear()
+{
+    termIds_.clear();
+    postings_.clear();
+    documents_.clear();
+    totalLength_ = 0;
+    sessionIds_.clear();
+    sessionNumbers_.clear();
+    indexedLogSize_ = 0;
+}
+
+void OllamaSearchIndex::addDocument(const QUuid &sessionId, const OllamaSessionStore::Turn &turn)
+{
+    auto sessionNumber = sessionNumbers_.constFind(sessionId);
+    if (sessionNumber == sessionNumbers_.constEnd()) {
+        sessionNumber = sessionNumbers_.insert(sessionId, sessionIds_.size());
+        sessionIds_.append(sessionId);
+    }
+
+    quint32 document = documents_.size();
+    QList<QString> tokens = tokenize(turn.prompt);
+    tokens.append(tokenize(turn.response));
+    documents_.push_back({*sessionNumber, quint32(tokens.size())});
+    totalLength_ += tokens.size();
+
+    QHash<quint32, quint32> termFrequencies;
+    for (const QString &token : std::as_const(tokens)) {
+        auto termId = termIds_.constFind(token);
+        if (termId == termIds_.constEnd()) {
+            termId = termIds_.insert(token, postings_.size());
+            postings_.emplace_back();
+        }
+        ++termFrequencies[*termId];
+    }
+
+    // Documents are only ever added, so every postings list stays in document order.
+    for (auto it = termFrequencies.cbegin(); it != termFrequencies.cend(); ++it) {
+        postings_[it.key()].push_back({document, it.value()});
+    }
+}
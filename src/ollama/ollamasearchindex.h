@@ -0,0 +1,87 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+#ifndef OLLAMASEARCHINDEX_H
+#define OLLAMASEARCHINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringView>
+#include <QUuid>
+
+#include <vector>
+
+#include "src/ollama/ollamasessionstore.h"
+
+/*
+ * Inverted index over the turns of the saved sessions, ranked with BM25.
+ * Only term ids and counts are kept, never the text, so it stays small however much was asked.
+ * It is built from the session store the first time it is searched and then grows with every appended turn.
+ * The postings are saved next to the session store, so later runs only read the turns appended since.
+ */
+class OllamaSearchIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Hit {
+        QUuid sessionId;
+        // The BM25 score of the best matching turn of the session.
+        float score = 0;
+    };
+
+    explicit OllamaSearchIndex(OllamaSessionStore *sessionStore, QObject *parent = nullptr);
+    ~OllamaSearchIndex();
+
+    // Gets the sessions whose turns match the query best, best first. Removed sessions are left out.
+    QList<Hit> search(const QString &query, int maxHits = 50);
+
+    // Splits text into lower case words of letters and digits, as indexed and searched.
+    static QList<QString> tokenize(QStringView text);
+
+private slots:
+    void handle_turnAppended(const QUuid &sessionId, const OllamaSessionStore::Turn &turn);
+
+private:
+    struct Posting {
+        quint32 document;
+        quint32 termFrequency;
+    };
+
+    // One turn.
+    struct Document {
+        quint32 session;
+        quint32 length;
+    };
+
+    void build();
+    void addDocument(const QUuid &sessionId, const OllamaSessionStore::Turn &turn);
+    // Loads the postings saved by an earlier run and returns false when there are none which match the log.
+    bool load();
+    void save();
+    void clear();
+
+    OllamaSessionStore *sessionStore_;
+    QString filePath_;
+    bool built_ = false;
+    // Whether turns were added since the postings were saved.
+    bool modified_ = false;
+    // Size of the log when the store was opened, saved postings of a longer log belong to records a crash cut off.
+    qint64 openedLogSize_ = 0;
+    // The turns before this offset in the log are indexed.
+    qint64 indexedLogSize_ = 0;
+
+    QHash<QString, quint32> termIds_;
+    // Postings by term id, in document order.
+    std::vector<std::vector<Posting>> postings_;
+    std::vector<Document> documents_;
+    quint64 totalLength_ = 0;
+    QList<QUuid> sessionIds_;
+    QHash<QUuid, quint32> sessionNumbers_;
+};
+
+#endif // OLLAMASEARCHINDEX_H
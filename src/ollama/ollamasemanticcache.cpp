@@ -0,0 +1,175 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+#include "src/ollama/ollamasemanticcache.h"
+
+static constexpr qsizetype MaxEntries = 2048;
+// Vectors and answers together, in bytes.
+static constexpr qsizetype MaxCost = 32 * 1024 * 1024;
+
+static float dotProduct(const float *a, const float *b, qsizetype size)
+{
+    qsizetype i = 0;
+    float result = 0;
+
+#if defined(__SSE__) || defined(_M_X64)
+    // Four lanes at a time, the tail is done below.
+    __m128 sum = _mm_setzero_ps();
+    for (; i + 4 <= size; i += 4) {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, sum);
+    result = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+
+    for (; i < size; ++i) {
+        result += a[i] * b[i];
+    }
+    return result;
+}
+
+OllamaSemanticCache::OllamaSemanticCache()
+{
+}
+
+OllamaSemanticCache::~OllamaSemanticCache()
+{
+}
+
+QByteArray OllamaSemanticCache::getPartitionKey(const OllamaData &data)
+{
+    OllamaData partition = data;
+    partition.setPrompt(QString());
+
+    return partition.getCacheKey();
+}
+
+bool OllamaSemanticCache::find(const QByteArray &partitionKey, const std::vector<float> &embedding, float threshold, OllamaResponse *response)
+{
+    if (dimensions_ == 0 || qsizetype(embedding.size()) != dimensions_) {
+        return false;
+    }
+
+    std::vector<float> query = normalized(embedding);
+
+    qsizetype bestIndex = -1;
+    float bestSimilarity = threshold;
+    for (qsizetype i = 0; i < entries_.size(); ++i) {
+        float similarity = dotProduct(query.data(), vectors_.data() + i * dimensions_, dimensions_);
+        // The partition is only compared for candidates, the dot product is the cheaper test.
+        if (similarity >= bestSimilarity && entries_.at(i).partitionKey == partitionKey) {
+            bestIndex = i;
+            bestSimilarity = similarity;
+        }
+    }
+    if (bestIndex == -1) {
+        return false;
+    }
+
+    Entry &entry = entries_[bestIndex];
+    entry.lastUsed = ++useCounter_;
+
+    response->setResponseText(entry.responseText);
+    response->setDone(true);
+    response->setDoneReason(entry.doneReason);
+    response->setContext(entry.context);
+    response->setSimilarity(bestSimilarity);
+
+    return true;
+}
+
+void OllamaSemanticCache::insert(const QByteArray &partitionKey, const std::vector<float> &embedding, OllamaResponse response)
+{
+    if (embedding.empty()) {
+        return;
+    }
+    if (qsizetype(embedding.size()) != dimensions_) {
+        clear();
+        dimensions_ = embedding.size();
+    }
+
+    Entry entry;
+    entry.partitionKey = partitionKey;
+    entry.responseText = response.getResponseText();
+    entry.doneReason = response.getDoneReason();
+    entry.context = response.getContext();
+    entry.lastUsed = ++useCounter_;
+
+    qsizetype entryCost = getEntryCost(entry);
+    if (entryCost > MaxCost) {
+        return;
+    }
+
+    // Least recently used first, until the new entry fits.
+    while (!entries_.isEmpty() && (entries_.size() >= MaxEntries || cost_ + entryCost > MaxCost)) {
+        qsizetype oldest = 0;
+        for (qsizetype i = 1; i < entries_.size(); ++i) {
+            if (entries_.at(i).lastUsed < entries_.at(oldest).lastUsed) {
+                oldest = i;
+            }
+        }
+        removeEntry(oldest);
+    }
+
+    std::vector<float> vector = normalized(embedding);
+    vectors_.insert(vectors_.end(), vector.begin(), vector.end());
+    entries_.append(entry);
+    cost_ += entryCost;
+}
+
+void OllamaSemanticCache::clear()
+{
+    vectors_.clear();
+    entries_.clear();
+    cost_ = 0;
+    dimensions_ = 0;
+}
+
+qsizetype OllamaSemanticCache::size() const
+{
+    return entries_.size();
+}
+
+std::vector<float> OllamaSemanticCache::normalized(const std::vector<float> &embedding)
+{
+    float length = std::sqrt(dotProduct(embedding.data(), embedding.data(), embedding.size()));
+
+    std::vector<float> result(embedding);
+    if (length > 0) {
+        for (float &value : result) {
+            value /= length;
+        }
+    }
+    return result;
+}
+
+qsizetype OllamaSemanticCache::getEntryCost(const Entry &entry) const
+{
+    return dimensions_ * qsizetype(sizeof(float)) + entry.partitionKey.size() + entry.responseText.size() * qsizetype(sizeof(QChar))
+        + entry.doneReason.size() * qsizetype(sizeof(QChar)) + entry.context.size() * qsizetype(sizeof(qint64));
+}
+
+void OllamaSemanticCache::removeEntry(qsizetype index)
+{
+    cost_ -= getEntryCost(entries_.at(index));
+
+    // The last row takes the place of the removed one, so nothing else moves.
+    qsizetype last = entries_.size() - 1;
+    if (index != last) {
+        std::memcpy(vectors_.data() + index * dimensions_, vectors_.data() + last * dimensions_, dimensions_ * sizeof(float));
+        entries_[index] = entries_.at(last);
+    }
+    vectors_.resize(last * dimensions_);
+    entries_.removeLast();
+}
@@ -0,0 +1,66 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+#ifndef OLLAMASEMANTICCACHE_H
+#define OLLAMASEMANTICCACHE_H
+
+#include <QByteArray>
+#include <QList>
+
+#include <vector>
+
+#include "src/ollama/ollamadata.h"
+#include "src/ollama/ollamaresponse.h"
+
+/*
+ * Answers of earlier questions by the embedding of the question, so a reworded question gets the same answer.
+ * The embeddings are normalized and stored in one contiguous array, which makes a lookup a run of dot products
+ * over memory read front to back. Answers are only matched within the same partition: same endpoint, model,
+ * system prompt and options, everything of the request except its prompt.
+ */
+class OllamaSemanticCache
+{
+public:
+    OllamaSemanticCache();
+    ~OllamaSemanticCache();
+
+    // Gets the partition of the data, the cache key of everything except the prompt.
+    static QByteArray getPartitionKey(const OllamaData &data);
+
+    // Finds the most similar earlier question in the partition. Returns false when none is at least as similar as the threshold.
+    // The similarity is set on response, which is the cosine similarity of the embeddings.
+    bool find(const QByteArray &partitionKey, const std::vector<float> &embedding, float threshold, OllamaResponse *response);
+    // Stores the answer to the question with the given embedding, evicting the least recently used answers when full.
+    void insert(const QByteArray &partitionKey, const std::vector<float> &embedding, OllamaResponse response);
+    void clear();
+
+    // Gets the number of cached answers.
+    qsizetype size() const;
+
+private:
+    struct Entry {
+        QByteArray partitionKey;
+        QString responseText;
+        QString doneReason;
+        QList<qint64> context;
+        quint64 lastUsed = 0;
+    };
+
+    // Scales the embedding to unit length, so the dot product is the cosine similarity.
+    static std::vector<float> normalized(const std::vector<float> &embedding);
+    // Gets the bytes an entry takes, its row of the vector array included.
+    qsizetype getEntryCost(const Entry &entry) const;
+    void removeEntry(qsizetype index);
+
+    // Length of every embedding, set by the first one. A different embedding model empties the cache.
+    qsizetype dimensions_ = 0;
+    // Row i holds the embedding of entries_[i].
+    std::vector<float> vectors_;
+    QList<Entry> entries_;
+    qsizetype cost_ = 0;
+    quint64 useCounter_ = 0;
+};
+
+#endif // OLLAMASEMANTICCACHE_H
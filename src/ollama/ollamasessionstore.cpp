@@ -0,0 +1,412 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include <QDebug>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtEndian>
+
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+#include "src/ollama/ollamasessionstore.h"
+
+// offset (8), length (4), type (2), checksum (2), session uuid (16), all little endian.
+static constexpr qsizetype IndexEntrySize = 32;
+// Set in the type of the last entry of every batch.
+static constexpr quint16 BatchEndFlag = 0x8000;
+// Turns arriving within this time are written together.
+static constexpr int BatchIntervalMs = 500;
+
+static quint16 checksum(QByteArrayView payload)
+{
+    return qChecksum(payload);
+}
+
+// Marks the last entry of the index data as the end of a batch.
+static void markBatchEnd(QByteArray &index)
+{
+    uchar *type = reinterpret_cast<uchar *>(index.data()) + index.size() - IndexEntrySize + 12;
+    qToLittleEndian<quint16>(qFromLittleEndian<quint16>(type) | BatchEndFlag, type);
+}
+
+// Writes the data at the position and waits until it reached the disk.
+// Writing at a position instead of appending makes a failed batch safe to write again.
+static bool writeAndSync(const QString &path, qint64 position, const QByteArray &data)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadWrite)) {
+        qWarning() << "Error opening session store:" << file.errorString();
+        return false;
+    }
+    if (!file.seek(position) || file.write(data) != data.size() || !file.flush()) {
+        qWarning() << "Error writing session store:" << file.errorString();
+        return false;
+    }
+#ifdef Q_OS_UNIX
+    ::fsync(file.handle());
+#endif
+    return true;
+}
+
+OllamaSessionStore::OllamaSessionStore(const QString &directory, QObject *parent)
+    : QObject(parent)
+    , directory_(directory)
+    , logPath_(directory + QStringLiteral("/sessions.log"))
+    , indexPath_(directory + QStringLiteral("/sessions.idx"))
+{
+    QDir().mkpath(directory);
+
+    writerPool_.setMaxThreadCount(1);
+    batchTimer_.setSingleShot(true);
+    batchTimer_.setInterval(BatchIntervalMs);
+    connect(&batchTimer_, &QTimer::timeout, this, &OllamaSessionStore::writeBatch);
+
+    open();
+}
+
+OllamaSessionStore::~OllamaSessionStore()
+{
+    writerPool_.waitForDone();
+
+    // Includes the batch which was in flight, writing it again at the same position does no harm.
+    if (writable_ && !unwrittenLog_.isEmpty() && writeAndSync(logPath_, writtenLogSize_, unwrittenLog_)) {
+        markBatchEnd(unwrittenIndex_);
+        writeAndSync(indexPath_, writtenIndexSize_, unwrittenIndex_);
+    }
+}
+
+void OllamaSessionStore::open()
+{
+    logFile_.setFileName(logPath_);
+    QFile indexFile(indexPath_);
+    if (!logFile_.open(QIODevice::ReadWrite) || !indexFile.open(QIODevice::ReadWrite)) {
+        qWarning() << "Error opening session store:" << logFile_.errorString() << indexFile.errorString();
+        return;
+    }
+
+    qint64 logSize = logFile_.size();
+    qint64 indexSize = indexFile.size();
+    logMap_ = logSize > 0 ? logFile_.map(0, logSize) : nullptr;
+    logMapSize_ = logMap_ ? logSize : 0;
+    uchar *indexMap = indexSize > 0 ? indexFile.map(0, indexSize) : nullptr;
+
+    // Without the maps nothing can be validated, and cutting the files would lose every session.
+    if ((logSize > 0 && !logMap_) || (indexSize > 0 && !indexMap)) {
+        qWarning() << "Error mapping session store, sessions are neither loaded nor saved:" << logFile_.errorString()
+                   << indexFile.errorString();
+        if (logMap_) {
+            logFile_.unmap(logMap_);
+        }
+        if (indexMap) {
+            indexFile.unmap(indexMap);
+        }
+        logMap_ = nullptr;
+        logMapSize_ = 0;
+        logFile_.close();
+        return;
+    }
+
+    qint64 entryCount = indexMap ? indexSize / IndexEntrySize : 0;
+
+    // A batch is only written once the one before it is synced, so a crash can only tear the last batch.
+    // Its end mark may be missing too, so records are checked from the second to last mark on.
+    qint64 checkedIndexSize = 0;
+    int batchEnds = 0;
+    for (qint64 position = (entryCount - 1) * IndexEntrySize; position >= 0; position -= IndexEntrySize) {
+        if ((qFromLittleEndian<quint16>(indexMap + position + 12) & BatchEndFlag) && ++batchEnds == 2) {
+            checkedIndexSize = position + IndexEntrySize;
+            break;
+        }
+    }
+
+    qint64 validLogSize = 0;
+    qint64 validIndexSize = 0;
+    for (qint64 position = 0; position < entryCount * IndexEntrySize; position += IndexEntrySize) {
+        const uchar *entryData = indexMap + position;
+        IndexEntry entry;
+        entry.offset = qFromLittleEndian<qint64>(entryData);
+        entry.length = qFromLittleEndian<quint32>(entryData + 8);
+        quint16 type = qFromLittleEndian<quint16>(entryData + 12) & ~BatchEndFlag;
+        quint16 entryChecksum = qFromLittleEndian<quint16>(entryData + 14);
+        QUuid sessionId = QUuid::fromRfc4122(QByteArrayView(entryData + 16, 16));
+
+        // Everything from the first entry which does not match its record on was torn by a crash.
+        if (entry.offset < validLogSize || entry.offset + entry.length > logMapSize_) {
+            break;
+        }
+        QByteArrayView payload(logMap_ + entry.offset, entry.length);
+        if (position >= checkedIndexSize && checksum(payload) != entryChecksum) {
+            break;
+        }
+        // Records end with a newline, so the log reads as JSON lines.
+        validLogSize = entry.offset + entry.length + 1;
+        validIndexSize = position + IndexEntrySize;
+
+        // Only the titles are read, turns stay on disk until their transcript is loaded.
+        if (type == SessionCreatedRecord) {
+            QJsonObject json = QJsonDocument::fromJson(payload.toByteArray()).object();
+            SessionEntry &session = sessions_[sessionId];
+            session.id = sessionId;
+            session.title = json.value(QLatin1String("title")).toString();
+            session.created = QDateTime::fromMSecsSinceEpoch(json.value(QLatin1String("created")).toInteger());
+            session.lastOffset = entry.offset;
+        } else if (type == TurnRecord) {
+            auto it = sessions_.find(sessionId);
+            if (it != sessions_.end()) {
+                it->turns.append(entry);
+                it->lastOffset = entry.offset;
+            }
+        } else if (type == SessionRemovedRecord) {
+            sessions_.remove(sessionId);
+        }
+    }
+
+    if (indexMap) {
+        indexFile.unmap(indexMap);
+    }
+    if (validIndexSize != indexSize) {
+        qWarning() << "Session store index cut to" << validIndexSize << "of" << indexSize << "bytes";
+        indexFile.resize(validIndexSize);
+    }
+    if (validLogSize != logSize) {
+        qWarning() << "Session store log cut to" << validLogSize << "of" << logSize << "bytes";
+        logFile_.unmap(logMap_);
+        logFile_.resize(validLogSize);
+        logMap_ = validLogSize > 0 ? logFile_.map(0, validLogSize) : nullptr;
+        logMapSize_ = logMap_ ? validLogSize : 0;
+    }
+    writtenLogSize_ = validLogSize;
+    writtenIndexSize_ = validIndexSize;
+    writable_ = true;
+}
+
+OllamaSessionStore::Session OllamaSessionStore::toSession(const SessionEntry &entry)
+{
+    Session session;
+    session.id = entry.id;
+    session.title = entry.title;
+    session.created = entry.created;
+    session.turnCount = entry.turns.size();
+    return session;
+}
+
+OllamaSessionStore::Session OllamaSessionStore::getSession(const QUuid &sessionId) const
+{
+    auto it = sessions_.constFind(sessionId);
+    return it == sessions_.constEnd() ? Session() : toSession(*it);
+}
+
+QList<OllamaSessionStore::Session> OllamaSessionStore::getSessions() const
+{
+    QList<const SessionEntry *> entries;
+    entries.reserve(sessions_.size());
+    for (const SessionEntry &entry : sessions_) {
+        entries.append(&entry);
+    }
+    std::sort(entries.begin(), entries.end(), [](const SessionEntry *a, const SessionEntry *b) {
+        return a->lastOffset > b->lastOffset;
+    });
+
+    QList<Session> sessions;
+    sessions.reserve(entries.size());
+    for (const SessionEntry *entry : std::as_const(entries)) {
+        sessions.append(toSession(*entry));
+    }
+    return sessions;
+}
+
+QUuid OllamaSessionStore::createSession(const QString &title)
+{
+    SessionEntry session;
+    session.id = QUuid::createUuid();
+    session.title = title;
+    session.created = QDateTime::currentDateTime();
+
+    QJsonObject json{{"title", title}, {"created", session.created.toMSecsSinceEpoch()}};
+    session.lastOffset = appendRecord(SessionCreatedRecord, session.id, QJsonDocument(json).toJson(QJsonDocument::Compact)).offset;
+    sessions_.insert(session.id, session);
+
+    emit signal_sessionsChanged();
+    return session.id;
+}
+
+void OllamaSessionStore::appendTurn(const QUuid &sessionId, const Turn &turn)
+{
+    auto it = sessions_.find(sessionId);
+    if (it == sessions_.end()) {
+        return;
+    }
+
+    QJsonObject json{{"prompt", turn.prompt},
+                     {"response", turn.response},
+                     {"model", turn.model},
+                     {"started", turn.started.toMSecsSinceEpoch()},
+                     {"first_token_ms", turn.firstTokenMs},
+                     {"duration_ms", turn.durationMs}};
+    IndexEntry entry = appendRecord(TurnRecord, sessionId, QJsonDocument(json).toJson(QJsonDocument::Compact));
+    it->turns.append(entry);
+    it->lastOffset = entry.offset;
+
+    emit signal_turnAppended(sessionId, turn);
+    emit signal_sessionsChanged();
+}
+
+QList<OllamaSessionStore::Turn> OllamaSessionStore::loadTranscript(const QUuid &sessionId)
+{
+    QList<Turn> turns;
+
+    const SessionEntry session = sessions_.value(sessionId);
+    turns.reserve(session.turns.size());
+    for (const IndexEntry &entry : session.turns) {
+        turns.append(readTurn(entry));
+    }
+    return turns;
+}
+
+void OllamaSessionStore::forEachTurn(const std::function<void(const QUuid &sessionId, const Turn &turn)> &function, qint64 fromOffset)
+{
+    // Copied, the function may append turns.
+    const QHash<QUuid, SessionEntry> sessions = sessions_;
+    for (const SessionEntry &session : sessions) {
+        if (session.lastOffset < fromOffset) {
+            continue;
+        }
+        for (const IndexEntry &entry : session.turns) {
+            if (entry.offset >= fromOffset) {
+                function(session.id, readTurn(entry));
+            }
+        }
+    }
+}
+
+qint64 OllamaSessionStore::getLogSize() const
+{
+    return writtenLogSize_ + unwrittenLog_.size();
+}
+
+QString OllamaSessionStore::getDirectory() const
+{
+    return directory_;
+}
+
+void OllamaSessionStore::removeSession(const QUuid &sessionId)
+{
+    if (!sessions_.remove(sessionId)) {
+        return;
+    }
+    appendRecord(SessionRemovedRecord, sessionId, QByteArray("{}"));
+
+    emit signal_sessionsChanged();
+}
+
+OllamaSessionStore::Turn OllamaSessionStore::readTurn(const IndexEntry &entry)
+{
+    QJsonObject json = QJsonDocument::fromJson(readRecord(entry)).object();
+
+    Turn turn;
+    turn.prompt = json.value(QLatin1String("prompt")).toString();
+    turn.response = json.value(QLatin1String("response")).toString();
+    turn.model = json.value(QLatin1String("model")).toString();
+    turn.started = QDateTime::fromMSecsSinceEpoch(json.value(QLatin1String("started")).toInteger());
+    turn.firstTokenMs = json.value(QLatin1String("first_token_ms")).toInteger(-1);
+    turn.durationMs = json.value(QLatin1String("duration_ms")).toInteger();
+    return turn;
+}
+
+OllamaSessionStore::IndexEntry OllamaSessionStore::appendRecord(RecordType type, const QUuid &sessionId, const QByteArray &payload)
+{
+    IndexEntry entry;
+    entry.offset = writtenLogSize_ + unwrittenLog_.size();
+    entry.length = payload.size();
+
+    unwrittenLog_.append(payload);
+    unwrittenLog_.append('\n');
+
+    uchar entryData[IndexEntrySize];
+    qToLittleEndian<qint64>(entry.offset, entryData);
+    qToLittleEndian<quint32>(entry.length, entryData + 8);
+    qToLittleEndian<quint16>(type, entryData + 12);
+    qToLittleEndian<quint16>(checksum(payload), entryData + 14);
+    QByteArray uuid = sessionId.toRfc4122();
+    std::copy(uuid.cbegin(), uuid.cend(), entryData + 16);
+    unwrittenIndex_.append(reinterpret_cast<const char *>(entryData), IndexEntrySize);
+
+    if (!batchTimer_.isActive()) {
+        batchTimer_.start();
+    }
+    return entry;
+}
+
+QByteArray OllamaSessionStore::readRecord(const IndexEntry &entry)
+{
+    if (entry.offset >= writtenLogSize_) {
+        return unwrittenLog_.mid(entry.offset - writtenLogSize_, entry.length);
+    }
+
+    // The map only grows when a record is read which was written after it was made.
+    if (entry.offset + entry.length > logMapSize_) {
+        if (logMap_) {
+            logFile_.unmap(logMap_);
+        }
+        logMap_ = logFile_.map(0, writtenLogSize_);
+        logMapSize_ = logMap_ ? writtenLogSize_ : 0;
+        if (!logMap_) {
+            qWarning() << "Error mapping session store:" << logFile_.errorString();
+            return QByteArray();
+        }
+    }
+    return QByteArray(reinterpret_cast<const char *>(logMap_ + entry.offset), entry.length);
+}
+
+void OllamaSessionStore::writeBatch()
+{
+    if (!writable_ || batchLogSize_ != 0 || unwrittenLog_.isEmpty()) {
+        return;
+    }
+
+    batchLogSize_ = unwrittenLog_.size();
+    batchIndexSize_ = unwrittenIndex_.size();
+    QByteArray log = unwrittenLog_;
+    QByteArray index = unwrittenIndex_;
+    markBatchEnd(index);
+    QString logPath = logPath_;
+    QString indexPath = indexPath_;
+    qint64 logPosition = writtenLogSize_;
+    qint64 indexPosition = writtenIndexSize_;
+
+    writerPool_.start([this, log, index, logPath, indexPath, logPosition, indexPosition]() {
+        // The index only points at records which are on disk.
+        bool success = writeAndSync(logPath, logPosition, log) && writeAndSync(indexPath, indexPosition, index);
+        QMetaObject::invokeMethod(
+            this,
+            [this, success]() {
+                handleBatchWritten(success);
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void OllamaSessionStore::handleBatchWritten(bool success)
+{
+    if (success) {
+        unwrittenLog_.remove(0, batchLogSize_);
+        unwrittenIndex_.remove(0, batchIndexSize_);
+        writtenLogSize_ += batchLogSize_;
+        writtenIndexSize_ += batchIndexSize_;
+    }
+    batchLogSize_ = 0;
+    batchIndexSize_ = 0;
+
+    // Records queued while the batch was written, or a failed batch to try again.
+    if (!unwrittenLog_.isEmpty() && !batchTimer_.isActive()) {
+        batchTimer_.start();
+    }
+}
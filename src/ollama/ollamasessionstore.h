@@ -0,0 +1,140 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+#ifndef OLLAMASESSIONSTORE_H
+#define OLLAMASESSIONSTORE_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <QTimer>
+#include <QUuid>
+
+#include <functional>
+
+/*
+ * Saved chat sessions, in two append-only files.
+ * sessions.log holds one JSON record per line: a session being created, a turn of it, or it being removed.
+ * sessions.idx holds a 32 byte entry per record with its offset, length, checksum, type and session, so opening
+ * the store only reads the index and the session titles through a memory map, and a transcript is read when asked for.
+ * Records are written in batches on a worker thread, the log before the index and both synced to disk, so a crash
+ * loses at most the last batch and never leaves the index pointing at a partial record. The last entry of a batch
+ * is marked, so opening only checksums the records which a crash could have torn.
+ */
+class OllamaSessionStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Session {
+        QUuid id;
+        QString title;
+        QDateTime created;
+        int turnCount = 0;
+    };
+
+    struct Turn {
+        QString prompt;
+        QString response;
+        QString model;
+        QDateTime started;
+        // Milliseconds from sending the prompt to the first token, -1 when no token arrived.
+        qint64 firstTokenMs = -1;
+        // Milliseconds from sending the prompt to the end of the response.
+        qint64 durationMs = 0;
+    };
+
+    explicit OllamaSessionStore(const QString &directory, QObject *parent = nullptr);
+    // Writes what is still queued before returning.
+    ~OllamaSessionStore();
+
+    // Gets all sessions, the one with the latest turn first.
+    QList<Session> getSessions() const;
+    // Gets the session with the id, or a session with a null id when there is none.
+    Session getSession(const QUuid &sessionId) const;
+    // Creates a session and returns its id.
+    QUuid createSession(const QString &title);
+    // Appends a turn to the session. It is written to disk with the next batch, but readable right away.
+    void appendTurn(const QUuid &sessionId, const Turn &turn);
+    // Reads all turns of the session from the log.
+    QList<Turn> loadTranscript(const QUuid &sessionId);
+    // Reads the turns of all sessions one at a time, without keeping them in memory.
+    // Only turns from fromOffset in the log on are read, see getLogSize.
+    void forEachTurn(const std::function<void(const QUuid &sessionId, const Turn &turn)> &function, qint64 fromOffset = 0);
+    // Gets the size of the log, records which are not written yet included. Records appended later start at or after it.
+    qint64 getLogSize() const;
+    // Gets the directory the store is kept in.
+    QString getDirectory() const;
+    // Removes the session from the list. Its records stay in the log, which is only ever appended to.
+    void removeSession(const QUuid &sessionId);
+
+signals:
+    void signal_sessionsChanged();
+    void signal_turnAppended(const QUuid &sessionId, const OllamaSessionStore::Turn &turn);
+
+private:
+    enum RecordType : quint16 {
+        SessionCreatedRecord = 1,
+        TurnRecord = 2,
+        SessionRemovedRecord = 3
+    };
+
+    struct IndexEntry {
+        qint64 offset = 0;
+        quint32 length = 0;
+    };
+
+    struct SessionEntry {
+        QUuid id;
+        QString title;
+        QDateTime created;
+        QList<IndexEntry> turns;
+        // Offset of the latest record of the session, which orders the session list.
+        qint64 lastOffset = 0;
+    };
+
+    // Maps both files, validates the index against the log and cuts off what a crash left half written.
+    // When a file cannot be opened or mapped, the store starts empty and does not touch the files.
+    void open();
+    // Queues the record for the next batch and returns where it will be in the log.
+    IndexEntry appendRecord(RecordType type, const QUuid &sessionId, const QByteArray &payload);
+    // Gets the record at the entry, from the map or from the records which are not written yet.
+    QByteArray readRecord(const IndexEntry &entry);
+    Turn readTurn(const IndexEntry &entry);
+    static Session toSession(const SessionEntry &entry);
+    // Hands the queued records to the worker thread, unless a batch is still being written.
+    void writeBatch();
+    void handleBatchWritten(bool success);
+
+    QString directory_;
+    QString logPath_;
+    QString indexPath_;
+    QFile logFile_;
+    uchar *logMap_ = nullptr;
+    qint64 logMapSize_ = 0;
+
+    // False when the store could not be opened, new records then only live in memory and the files are left alone.
+    bool writable_ = false;
+    // Bytes on disk, everything after that is in the unwritten buffers.
+    qint64 writtenLogSize_ = 0;
+    qint64 writtenIndexSize_ = 0;
+    QByteArray unwrittenLog_;
+    QByteArray unwrittenIndex_;
+    // Size of the front of the unwritten buffers which the worker is writing, 0 when idle.
+    qsizetype batchLogSize_ = 0;
+    qsizetype batchIndexSize_ = 0;
+
+    QHash<QUuid, SessionEntry> sessions_;
+    QTimer batchTimer_;
+    // One thread, so batches reach the disk in order.
+    QThreadPool writerPool_;
+};
+
+#endif // OLLAMASESSIONSTORE_H
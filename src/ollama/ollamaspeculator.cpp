@@ -0,0 +1,106 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include "src/ollama/ollamarequest.h"
+#include "src/ollama/ollamaspeculator.h"
+#include "src/ollama/ollamasystem.h"
+
+// Finished answers kept around, for the text the user may return to with undo or cursor movement.
+static constexpr int MaxFinishedSpeculations = 16;
+
+OllamaSpeculator::OllamaSpeculator(OllamaSystem *ollamaSystem, QObject *parent)
+    : QObject(parent)
+    , ollamaSystem_(ollamaSystem)
+{
+}
+
+OllamaSpeculator::~OllamaSpeculator()
+{
+}
+
+void OllamaSpeculator::speculate(OllamaData data)
+{
+    QByteArray key = data.getCacheKey();
+    if (speculations_.contains(key)) {
+        return;
+    }
+
+    // Background requests make way for anything the user is waiting on.
+    data.setPriority(OllamaData::BackgroundPriority);
+    OllamaRequest *request = ollamaSystem_->ollamaRequest(data);
+
+    Speculation speculation;
+    speculation.requestId = request->getId();
+    speculations_.insert(key, speculation);
+    keysByRequestId_.insert(request->getId(), key);
+
+    connect(request, &OllamaRequest::signal_finished, this, &OllamaSpeculator::handle_ollamaRequestFinished);
+}
+
+bool OllamaSpeculator::take(const OllamaData &data, OllamaResponse *response, OllamaRequest **request)
+{
+    *request = nullptr;
+
+    auto it = speculations_.find(data.getCacheKey());
+    if (it == speculations_.end()) {
+        return false;
+    }
+
+    if (it->finished) {
+        *response = it->response;
+        return true;
+    }
+
+    OllamaRequest *running = ollamaSystem_->getRequest(it->requestId);
+    if (!running) {
+        return false;
+    }
+
+    it->taken = true;
+    *response = running->getResponse();
+    *request = running;
+    ollamaSystem_->setRequestPriority(running->getId(), data.getPriority());
+
+    return true;
+}
+
+void OllamaSpeculator::cancelRunning()
+{
+    QList<quint64> requestIds;
+    for (const Speculation &speculation : std::as_const(speculations_)) {
+        if (!speculation.finished && !speculation.taken) {
+            requestIds.append(speculation.requestId);
+        }
+    }
+
+    // Cancelling finishes the request synchronously, which removes its speculation.
+    for (quint64 requestId : requestIds) {
+        ollamaSystem_->cancelRequest(requestId);
+    }
+}
+
+void OllamaSpeculator::handle_ollamaRequestFinished(OllamaResponse ollamaResponse)
+{
+    QByteArray key = keysByRequestId_.take(ollamaResponse.getRequestId());
+    auto it = speculations_.find(key);
+    if (it == speculations_.end()) {
+        return;
+    }
+
+    // Only complete answers are worth showing again.
+    if (ollamaResponse.getErrorType() != OllamaResponse::NoError || !ollamaResponse.isDone()) {
+        speculations_.erase(it);
+        return;
+    }
+
+    it->finished = true;
+    it->response = ollamaResponse;
+
+    finishedKeys_.append(key);
+    while (finishedKeys_.size() > MaxFinishedSpeculations) {
+        speculations_.remove(finishedKeys_.takeFirst());
+    }
+}
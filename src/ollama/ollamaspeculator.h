@@ -0,0 +1,61 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+#ifndef OLLAMASPECULATOR_H
+#define OLLAMASPECULATOR_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+
+#include "src/ollama/ollamadata.h"
+#include "src/ollama/ollamaresponse.h"
+
+class OllamaRequest;
+class OllamaSystem;
+
+/*
+ * Keeps answers warm which are likely to be asked for next.
+ * While the user pauses typing, requests are made at background priority. When the same data is
+ * asked for later, the speculation is taken over: a finished one is shown at once, a running one
+ * is raised to the priority of the asker and streams the rest of its text to it.
+ */
+class OllamaSpeculator : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit OllamaSpeculator(OllamaSystem *ollamaSystem, QObject *parent = nullptr);
+    ~OllamaSpeculator();
+
+    // Starts a background request for the data, unless one for the same data is running or done.
+    void speculate(OllamaData data);
+    // Takes over the speculation for the data and returns false when there is none.
+    // The text produced so far is set on response. While the speculation still runs, its handle is set on request
+    // and raised to the priority of the data; connect to it for the rest of the text. Otherwise request is set to nullptr.
+    bool take(const OllamaData &data, OllamaResponse *response, OllamaRequest **request);
+    // Cancels the speculations nobody took over, because the text they were made for changed. Finished ones are kept.
+    void cancelRunning();
+
+private slots:
+    void handle_ollamaRequestFinished(OllamaResponse ollamaResponse);
+
+private:
+    struct Speculation {
+        quint64 requestId = 0;
+        bool taken = false;
+        bool finished = false;
+        OllamaResponse response;
+    };
+
+    OllamaSystem *ollamaSystem_;
+    QHash<QByteArray, Speculation> speculations_;
+    QHash<quint64, QByteArray> keysByRequestId_;
+    // Keys of the finished speculations, oldest first.
+    QList<QByteArray> finishedKeys_;
+};
+
+#endif // OLLAMASPECULATOR_H
@@ -0,0 +1,69 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonParseError>
+
+#include "src/ollama/ollamastreamdecoder.h"
+
+QList<QJsonObject> OllamaStreamDecoder::feed(const QByteArray &chunk)
+{
+    QList<QJsonObject> records;
+
+    buffer_.append(chunk);
+
+    qsizetype start = 0;
+    qsizetype newline = buffer_.indexOf('\n', scanned_);
+    while (newline != -1) {
+        parseLine(QByteArrayView(buffer_).sliced(start, newline - start), records);
+        start = newline + 1;
+        newline = buffer_.indexOf('\n', start);
+    }
+
+    if (start > 0) {
+        buffer_.remove(0, start);
+    }
+    scanned_ = buffer_.size();
+
+    return records;
+}
+
+QList<QJsonObject> OllamaStreamDecoder::finish()
+{
+    QList<QJsonObject> records;
+
+    parseLine(QByteArrayView(buffer_), records);
+    buffer_.clear();
+    scanned_ = 0;
+
+    return records;
+}
+
+int OllamaStreamDecoder::getParseErrorCount() const
+{
+    return parseErrorCount_;
+}
+
+void OllamaStreamDecoder::parseLine(QByteArrayView line, QList<QJsonObject> &records)
+{
+    line = line.trimmed();
+    if (line.isEmpty()) {
+        return;
+    }
+
+    // fromRawData avoids copying the line, it is only referenced while parsing.
+    QJsonParseError error;
+    QJsonDocument jsonDoc = QJsonDocument::fromJson(QByteArray::fromRawData(line.data(), line.size()), &error);
+
+    if (error.error != QJsonParseError::NoError || !jsonDoc.isObject()) {
+        ++parseErrorCount_;
+        qWarning() << "ollamastreamdecoder could not parse record:" << error.errorString();
+        return;
+    }
+
+    records.append(jsonDoc.object());
+}
@@ -0,0 +1,40 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+#ifndef OLLAMASTREAMDECODER_H
+#define OLLAMASTREAMDECODER_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QJsonObject>
+#include <QList>
+
+/*
+ * Splits a streamed Ollama response (newline delimited JSON) into records.
+ * Network chunks do not follow record boundaries: a chunk can hold several records or end halfway one,
+ * so incomplete data is carried over to the next call.
+ * Documentation: https://ollama.readthedocs.io/en/api/#generate-a-completion
+ */
+class OllamaStreamDecoder
+{
+public:
+    // Appends a chunk read from the network and returns every record it completed.
+    QList<QJsonObject> feed(const QByteArray &chunk);
+    // Returns the last record when the stream ended without a trailing newline (non streaming responses).
+    QList<QJsonObject> finish();
+
+    // Gets the number of lines which were not valid JSON.
+    int getParseErrorCount() const;
+
+private:
+    void parseLine(QByteArrayView line, QList<QJsonObject> &records);
+
+    QByteArray buffer_;
+    // Position up to which buffer_ is known to hold no newline, so carried over data is not scanned twice.
+    qsizetype scanned_ = 0;
+    int parseErrorCount_ = 0;
+};
+
+#endif // OLLAMASTREAMDECODER_H
@@ -8,18 +8,43 @@
 #include <KLocalizedString>
 
 #include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
 #include <QJsonObject>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QObject>
+#include <QRandomGenerator>
 #include <QStringLiteral>
+#include <QTimer>
+#include <QUrl>
+
+#include <algorithm>
 
 #include "src/ollama/ollamadata.h"
+#include "src/ollama/ollamarequest.h"
 #include "src/ollama/ollamaresponse.h"
 #include "src/ollama/ollamasystem.h"
 
+// The num_ctx Ollama runs a model with when the Modelfile does not set one.
+static const int DefaultContextLength = 2048;
+
+// How long a fetched model list is used before it is revalidated.
+static const qint64 ModelsTtlMs = 60 * 1000;
+
+// Retries of a request whose connection failed before it answered, waiting 0.5, 1, 2 and 4 seconds (with jitter).
+static const int MaxRetries = 4;
+static const int RetryBaseDelayMs = 500;
+static const int RetryMaxDelayMs = 8000;
+
+// Times to first token the hedge delay is taken from, and how many are needed before requests are hedged.
+static const qsizetype MaxFirstTokenLatencies = 100;
+static const qsizetype MinFirstTokenLatencies = 10;
+
 OllamaSystem::OllamaSystem(QObject *parent)
     : parent(parent)
+    , networkManager_(new QNetworkAccessManager(this))
+    , endpointPool_(new OllamaEndpointPool(networkManager_, this))
 {
 }
 
@@ -29,119 +54,977 @@ OllamaSystem::~OllamaSystem()
 
 void OllamaSystem::fetchModels(OllamaData ollamaData)
 {
+    QString url = ollamaData.getOllamaUrl();
+    ModelsCacheEntry &entry = modelsCache_[url];
+
+    if (entry.reply || (entry.age.isValid() && !entry.age.hasExpired(ModelsTtlMs))) {
+        return;
+    }
+
     qDebug() << "ollamasystem is fetching models";
 
-    QNetworkAccessManager *manager = new QNetworkAccessManager(parent);
-    connect(manager, &QNetworkAccessManager::finished, this, [this](QNetworkReply *reply) {
+    QNetworkReply *reply = networkManager_->get(createRequest(url, QStringLiteral("/api/tags")));
+    entry.reply = reply;
+
+    connect(reply, &QNetworkReply::finished, this, [this, reply, url]() {
+        ModelsCacheEntry &entry = modelsCache_[url];
+        entry.reply = nullptr;
+
         if (reply->error() == QNetworkReply::NoError) {
             qDebug() << "ollamasystem got a reply from fetching models";
             QByteArray responseData = reply->readAll();
             QJsonDocument jsonDoc = QJsonDocument::fromJson(responseData);
 
+            QList<QJsonValue> modelsList;
             if (jsonDoc.isObject()) {
-                qDebug() << "ollamasystem has a json object with models";
                 QJsonObject jsonObj = jsonDoc.object();
                 if (jsonObj.contains("models") && jsonObj["models"].isArray()) {
-                    qDebug() << "ollamasystem identified models";
                     QJsonArray modelsArray = jsonObj["models"].toArray();
 
                     for (const QJsonValue &value : modelsArray) {
-                        qDebug() << "ollamasystem appending model";
-                        m_modelsList.append(value);
+                        modelsList.append(value);
                     }
-                    std::sort(m_modelsList.begin(), m_modelsList.end(), [](const QJsonValue &a, const QJsonValue &b) {
+                    std::sort(modelsList.begin(), modelsList.end(), [](const QJsonValue &a, const QJsonValue &b) {
                         return a.toObject()["name"].toString().toLower() < b.toObject()["name"].toString().toLower();
                     });
                 }
             }
 
-            qDebug() << "ollamasystem is emitting signal that it fetched models";
-            emit signal_modelsListLoaded(m_modelsList);
+            bool firstLoad = !entry.age.isValid();
+            entry.age.start();
+
+            if (firstLoad || modelsList != entry.models) {
+                entry.models = modelsList;
 
+                qDebug() << "ollamasystem is emitting signal that it fetched models";
+                emit signal_modelsListLoaded(url, entry.models);
+            }
         } else {
             qWarning() << "Error fetching model list:" << reply->errorString();
             m_errors.append(i18n("Error fetching model list: %1", reply->errorString()));
 
-            emit signal_errorFetchingModelsList(QString("Error fetching model list:").append(reply->errorString()));
+            emit signal_errorFetchingModelsList(url, i18n("Error fetching model list: %1", reply->errorString()));
         }
         reply->deleteLater();
     });
+}
+
+QList<QJsonValue> OllamaSystem::getModels(const QString &url) const
+{
+    return modelsCache_.value(url).models;
+}
+
+OllamaRequest *OllamaSystem::ollamaRequest(OllamaData ollamaData)
+{
+    OllamaRequest *ollamaRequest = new OllamaRequest(nextRequestId_++, ollamaData, this);
+    ollamaRequest->endpoint_ = ollamaData.getOllamaUrl();
+    requests_.insert(ollamaRequest->getId(), ollamaRequest);
+    connect(&ollamaRequest->hedgeTimer_, &QTimer::timeout, ollamaRequest, [this, ollamaRequest]() {
+        startHedge(ollamaRequest);
+    });
+    connect(&ollamaRequest->watchdog_, &QTimer::timeout, ollamaRequest, [ollamaRequest]() {
+        if (!ollamaRequest->reply_) {
+            return;
+        }
+        qWarning() << "ollamasystem timed out request" << ollamaRequest->getId() << "on" << ollamaRequest->endpoint_;
+
+        // Emits finished synchronously, which frees the slot.
+        ollamaRequest->timedOut_ = true;
+        ollamaRequest->reply_->abort();
+    });
+
+    OllamaResponse cachedResponse;
+    if (responseCacheEnabled_ && !ollamaData.isCacheBypassed() && OllamaResponseCache::isCacheable(ollamaData)
+        && responseCache_.find(ollamaData.getCacheKey(), &cachedResponse)) {
+        replayRequest(ollamaRequest, cachedResponse);
+        return ollamaRequest;
+    }
+
+    if (semanticCacheEnabled_ && !embeddingModel_.isEmpty() && ollamaData.isSemanticCacheAllowed() && !ollamaData.isCacheBypassed()) {
+        embedRequest(ollamaRequest);
+        return ollamaRequest;
+    }
+
+    queueRequest(ollamaRequest);
+
+    return ollamaRequest;
+}
+
+OllamaRequest *OllamaSystem::getRequest(quint64 requestId) const
+{
+    return requests_.value(requestId, nullptr);
+}
+
+void OllamaSystem::cancelRequest(quint64 requestId)
+{
+    OllamaRequest *request = requests_.value(requestId, nullptr);
+    if (!request) {
+        return;
+    }
+
+    request->cancelled_ = true;
+
+    if (request->reply_) {
+        // Emits finished synchronously, which cleans up the request.
+        request->reply_->abort();
+        return;
+    }
+
+    endpointQueues_[request->endpoint_].pending.removeOne(request);
+    request->finalResponse_.setErrorType(OllamaResponse::CancelledError);
+    request->finalResponse_.setErrorMessage(i18n("Request cancelled"));
+    finishRequest(request);
+}
+
+void OllamaSystem::setRequestPriority(quint64 requestId, OllamaData::Priority priority)
+{
+    OllamaRequest *request = requests_.value(requestId, nullptr);
+    if (!request || request->getData().getPriority() == priority) {
+        return;
+    }
+    request->data_.setPriority(priority);
+
+    EndpointQueue &queue = endpointQueues_[request->endpoint_];
+    if (queue.pending.removeOne(request)) {
+        enqueueRequest(request);
+        preemptFor(request);
+        scheduleRequests(request->endpoint_);
+    } else if (queue.running.removeOne(request)) {
+        // Keeps the running list ordered, so preemption still picks the least important request.
+        qsizetype index = 0;
+        while (index < queue.running.size() && queue.running.at(index)->getData().getPriority() >= priority) {
+            ++index;
+        }
+        queue.running.insert(index, request);
+    }
+}
+
+void OllamaSystem::setResponseCacheEnabled(bool responseCacheEnabled)
+{
+    responseCacheEnabled_ = responseCacheEnabled;
+}
+bool OllamaSystem::isResponseCacheEnabled() const
+{
+    return responseCacheEnabled_;
+}
+
+void OllamaSystem::setSemanticCacheEnabled(bool semanticCacheEnabled)
+{
+    semanticCacheEnabled_ = semanticCacheEnabled;
+}
+bool OllamaSystem::isSemanticCacheEnabled() const
+{
+    return semanticCacheEnabled_;
+}
+
+void OllamaSystem::setSemanticCacheThreshold(float semanticCacheThreshold)
+{
+    semanticCacheThreshold_ = semanticCacheThreshold;
+}
+float OllamaSystem::getSemanticCacheThreshold() const
+{
+    return semanticCacheThreshold_;
+}
+
+void OllamaSystem::setEmbeddingModel(const QString &embeddingModel)
+{
+    // Embeddings of different models can not be compared.
+    if (embeddingModel != embeddingModel_) {
+        semanticCache_.clear();
+    }
+    embeddingModel_ = embeddingModel;
+}
+QString OllamaSystem::getEmbeddingModel() const
+{
+    return embeddingModel_;
+}
+
+void OllamaSystem::setMaxParallelRequests(int maxParallelRequests)
+{
+    maxParallelRequests_ = qMax(1, maxParallelRequests);
+
+    const QStringList endpoints = endpointQueues_.keys();
+    for (const QString &endpoint : endpoints) {
+        scheduleRequests(endpoint);
+    }
+}
+int OllamaSystem::getMaxParallelRequests() const
+{
+    return maxParallelRequests_;
+}
+
+void OllamaSystem::setConnectTimeout(int connectTimeoutMs)
+{
+    connectTimeoutMs_ = std::max(0, connectTimeoutMs);
+}
+int OllamaSystem::getConnectTimeout() const
+{
+    return connectTimeoutMs_;
+}
+
+void OllamaSystem::setFirstTokenTimeout(int firstTokenTimeoutMs)
+{
+    firstTokenTimeoutMs_ = std::max(0, firstTokenTimeoutMs);
+}
+int OllamaSystem::getFirstTokenTimeout() const
+{
+    return firstTokenTimeoutMs_;
+}
+
+void OllamaSystem::setStallTimeout(int stallTimeoutMs)
+{
+    stallTimeoutMs_ = std::max(0, stallTimeoutMs);
+}
+int OllamaSystem::getStallTimeout() const
+{
+    return stallTimeoutMs_;
+}
+
+void OllamaSystem::setHedgePercentile(int hedgePercentile)
+{
+    hedgePercentile_ = std::clamp(hedgePercentile, 0, 99);
+}
+int OllamaSystem::getHedgePercentile() const
+{
+    return hedgePercentile_;
+}
+
+void OllamaSystem::setEndpoints(const QStringList &urls)
+{
+    endpointPool_->setEndpoints(urls);
+}
+QStringList OllamaSystem::getEndpoints() const
+{
+    return endpointPool_->getEndpoints();
+}
+
+bool OllamaSystem::isEndpointHealthy(const QString &url) const
+{
+    return endpointPool_->isHealthy(url);
+}
+
+void OllamaSystem::enqueueRequest(OllamaRequest *request, bool aheadOfSamePriority)
+{
+    QList<OllamaRequest *> &pending = endpointQueues_[request->endpoint_].pending;
+    OllamaData::Priority priority = request->getData().getPriority();
 
-    QUrl url(ollamaData.getOllamaUrl() + "/api/tags");
-    QNetworkRequest request(url);
-    manager->get(request);
+    qsizetype index = 0;
+    while (index < pending.size()) {
+        OllamaData::Priority queuedPriority = pending.at(index)->getData().getPriority();
+        if (queuedPriority < priority || (aheadOfSamePriority && queuedPriority == priority)) {
+            break;
+        }
+        ++index;
+    }
+    pending.insert(index, request);
 }
 
-void OllamaSystem::ollamaRequest(OllamaData ollamaData)
+void OllamaSystem::scheduleRequests(const QString &endpoint)
 {
-    QString sender = ollamaData.getSender();
+    EndpointQueue &queue = endpointQueues_[endpoint];
 
-    QJsonObject json_data;
-    json_data = ollamaData.toJson();
+    while (!queue.pending.isEmpty() && queue.running.size() < maxParallelRequests_) {
+        startRequest(queue.pending.takeFirst());
+    }
+}
 
-    QJsonDocument doc(json_data);
+void OllamaSystem::preemptFor(OllamaRequest *request)
+{
+    EndpointQueue &queue = endpointQueues_[request->endpoint_];
+    if (queue.running.size() < maxParallelRequests_) {
+        return;
+    }
+
+    // Ghost text is asked for at every typing pause, it must not keep restarting a chat question.
+    OllamaData::Priority preemptBelow = request->getData().getPriority();
+    if (preemptBelow == OllamaData::CompletionPriority) {
+        preemptBelow = OllamaData::ChatPriority;
+    }
+
+    // Lowest priority first, the running list is ordered from high to low.
+    for (qsizetype i = queue.running.size() - 1; i >= 0; --i) {
+        OllamaRequest *running = queue.running.at(i);
+        OllamaData::Priority priority = running->getData().getPriority();
+        if (priority >= preemptBelow) {
+            continue;
+        }
 
-    QNetworkAccessManager *manager = new QNetworkAccessManager(this);
+        if (running->hedgeEndpoint_ == request->endpoint_) {
+            // Only the duplicate runs here, the request itself keeps going elsewhere.
+            dropHedge(running);
+            return;
+        }
+
+        if (!running->streaming_) {
+            // Nothing was shown yet, so it can simply run again later.
+            running->requeued_ = true;
+        } else if (priority == OllamaData::BackgroundPriority) {
+            running->preempted_ = true;
+        } else {
+            // A chat answer which is being read keeps its slot.
+            continue;
+        }
+
+        // Emits finished synchronously, which frees the slot.
+        running->reply_->abort();
+        return;
+    }
+}
+
+QString OllamaSystem::selectEndpoint(const OllamaRequest *request) const
+{
+    QString url = request->getData().getOllamaUrl();
+    if (endpointPool_->getEndpoints().size() < 2 || !endpointPool_->contains(url)) {
+        return url;
+    }
 
-    QNetworkRequest request(QUrl(ollamaData.getOllamaUrl() + "/api/generate"));
+    QStringList candidates = endpointPool_->getAvailableEndpoints(request->getData().getModel());
+    // The requested endpoint wins ties, it is the one whose model is most likely loaded.
+    if (candidates.removeOne(url)) {
+        candidates.prepend(url);
+    }
+
+    QString selected = url;
+    qsizetype fewestOutstanding = -1;
+    for (const QString &candidate : std::as_const(candidates)) {
+        const EndpointQueue queue = endpointQueues_.value(candidate);
+        qsizetype outstanding = queue.pending.size() + queue.running.size();
+        if (fewestOutstanding < 0 || outstanding < fewestOutstanding) {
+            selected = candidate;
+            fewestOutstanding = outstanding;
+        }
+    }
+    return selected;
+}
+
+void OllamaSystem::queueRequest(OllamaRequest *request)
+{
+    request->endpoint_ = selectEndpoint(request);
+    enqueueRequest(request);
+    preemptFor(request);
+    scheduleRequests(request->endpoint_);
+}
+
+void OllamaSystem::embedRequest(OllamaRequest *ollamaRequest)
+{
+    QNetworkRequest request = createRequest(ollamaRequest->endpoint_, QStringLiteral("/api/embed"));
     request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    // Loading the embedding model counts like loading a model for the first token. After that the prompt goes to the model
+    // without an embedding.
+    if (connectTimeoutMs_ > 0 && firstTokenTimeoutMs_ > 0) {
+        request.setTransferTimeout(connectTimeoutMs_ + firstTokenTimeoutMs_);
+    }
 
-    QNetworkReply *reply = manager->post(request, doc.toJson());
+    QJsonObject json{{"model", embeddingModel_}, {"input", ollamaRequest->getData().getPrompt()}};
+    QNetworkReply *reply = networkManager_->post(request, QJsonDocument(json).toJson(QJsonDocument::Compact));
+
+    quint64 requestId = ollamaRequest->getId();
+    connect(reply, &QNetworkReply::finished, this, [this, reply, requestId]() {
+        reply->deleteLater();
+
+        // Cancelled while the prompt was embedded.
+        OllamaRequest *ollamaRequest = requests_.value(requestId, nullptr);
+        if (!ollamaRequest) {
+            return;
+        }
+
+        // Without an embedding the request simply goes to the model.
+        if (reply->error() != QNetworkReply::NoError) {
+            qWarning() << "Error embedding prompt:" << reply->errorString();
+        } else {
+            const QJsonArray values =
+                QJsonDocument::fromJson(reply->readAll()).object().value(QLatin1String("embeddings")).toArray().at(0).toArray();
+            ollamaRequest->embedding_.reserve(values.size());
+            for (const QJsonValue &value : values) {
+                ollamaRequest->embedding_.push_back(float(value.toDouble()));
+            }
+        }
+
+        OllamaResponse cachedResponse;
+        if (!ollamaRequest->embedding_.empty()
+            && semanticCache_.find(OllamaSemanticCache::getPartitionKey(ollamaRequest->getData()),
+                                   ollamaRequest->embedding_,
+                                   semanticCacheThreshold_,
+                                   &cachedResponse)) {
+            replayRequest(ollamaRequest, cachedResponse);
+            return;
+        }
+
+        queueRequest(ollamaRequest);
+    });
+}
+
+void OllamaSystem::startRequest(OllamaRequest *ollamaRequest)
+{
+    insertRunning(ollamaRequest, ollamaRequest->endpoint_);
+
+    ollamaRequest->reply_ = postRequest(ollamaRequest, ollamaRequest->endpoint_);
+    ollamaRequest->sent_.start();
+    armWatchdog(ollamaRequest, OllamaResponse::ConnectTimeoutError);
+
+    qint64 hedgeDelay = getHedgeDelay();
+    if (hedgeDelay >= 0) {
+        ollamaRequest->hedgeTimer_.start(hedgeDelay);
+    }
+}
+
+QNetworkReply *OllamaSystem::postRequest(OllamaRequest *ollamaRequest, const QString &endpoint)
+{
+    OllamaData ollamaData = ollamaRequest->getData();
+    QJsonDocument doc(ollamaData.toJson());
+
+    QString path = ollamaData.isChat() ? QStringLiteral("/api/chat") : QStringLiteral("/api/generate");
+    QNetworkRequest request = createRequest(endpoint, path);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+
+    QNetworkReply *reply = networkManager_->post(request, doc.toJson(QJsonDocument::Compact));
+
+    connect(reply, &QNetworkReply::metaDataChanged, ollamaRequest, [ollamaRequest]() {
+        // A request which was requeued, retried or hedged already told its receiver that it started.
+        if (ollamaRequest->metaDataEmitted_) {
+            return;
+        }
+        ollamaRequest->metaDataEmitted_ = true;
 
-    connect(reply, &QNetworkReply::metaDataChanged, this, [=, this]() {
         OllamaResponse ollamaResponse;
 
-        ollamaResponse.setReceiver(sender);
+        ollamaResponse.setRequestId(ollamaRequest->getId());
+        ollamaResponse.setReceiver(ollamaRequest->getData().getSender());
 
-        emit signal_ollamaRequestMetaDataChanged(ollamaResponse);
+        emit ollamaRequest->signal_metaDataChanged(ollamaResponse);
     });
 
-    connect(reply, &QNetworkReply::readyRead, this, [this, reply, sender]() {
-        QString responseChunk = reply->readAll();
-        QJsonDocument jsonDoc = QJsonDocument::fromJson(responseChunk.toUtf8());
-        QJsonObject jsonObj = jsonDoc.object();
+    // The request reached the server, from now on it is up to the model.
+    connect(reply, &QNetworkReply::requestSent, ollamaRequest, [this, ollamaRequest, reply]() {
+        if (reply == ollamaRequest->reply_ && ollamaRequest->watchdogError_ == OllamaResponse::ConnectTimeoutError) {
+            armWatchdog(ollamaRequest, OllamaResponse::FirstTokenTimeoutError);
+        }
+    });
 
-        if (jsonObj.contains("response")) {
-            OllamaResponse ollamaResponse;
+    connect(reply, &QNetworkReply::readyRead, ollamaRequest, [this, ollamaRequest, reply]() {
+        handleReplyReadyRead(ollamaRequest, reply);
+    });
+
+    connect(reply, &QNetworkReply::finished, ollamaRequest, [this, ollamaRequest, reply]() {
+        handleReplyFinished(ollamaRequest, reply);
+    });
+
+    return reply;
+}
+
+void OllamaSystem::insertRunning(OllamaRequest *request, const QString &endpoint)
+{
+    QList<OllamaRequest *> &running = endpointQueues_[endpoint].running;
+    OllamaData::Priority priority = request->getData().getPriority();
+
+    qsizetype index = 0;
+    while (index < running.size() && running.at(index)->getData().getPriority() >= priority) {
+        ++index;
+    }
+    running.insert(index, request);
+}
+
+void OllamaSystem::handleReplyReadyRead(OllamaRequest *ollamaRequest, QNetworkReply *reply)
+{
+    // An error record does not win a race or count as an answer, it is read when the reply finished.
+    if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() >= 400) {
+        return;
+    }
+
+    if (!ollamaRequest->receiving_) {
+        ollamaRequest->receiving_ = true;
+        ollamaRequest->hedgeTimer_.stop();
+
+        // The first reply to stream wins the race.
+        if (reply == ollamaRequest->hedgeReply_) {
+            promoteHedge(ollamaRequest);
+        } else if (ollamaRequest->hedgeReply_) {
+            dropHedge(ollamaRequest);
+        }
+
+        firstTokenLatencies_.append(ollamaRequest->sent_.elapsed());
+        if (firstTokenLatencies_.size() > MaxFirstTokenLatencies) {
+            firstTokenLatencies_.removeFirst();
+        }
+    }
+
+    armWatchdog(ollamaRequest, OllamaResponse::StallTimeoutError);
+    processStreamRecords(ollamaRequest, ollamaRequest->decoder_.feed(reply->readAll()));
+}
 
-            ollamaResponse.setReceiver(sender);
-            ollamaResponse.setResponseText(jsonObj["response"].toString());
+void OllamaSystem::armWatchdog(OllamaRequest *ollamaRequest, OllamaResponse::ErrorType timeout)
+{
+    int timeoutMs = 0;
+    switch (timeout) {
+    case OllamaResponse::ConnectTimeoutError:
+        timeoutMs = connectTimeoutMs_;
+        break;
+    case OllamaResponse::FirstTokenTimeoutError:
+        timeoutMs = firstTokenTimeoutMs_;
+        break;
+    case OllamaResponse::StallTimeoutError:
+        timeoutMs = stallTimeoutMs_;
+        break;
+    default:
+        break;
+    }
+
+    ollamaRequest->watchdogError_ = timeout;
+    if (timeoutMs > 0) {
+        ollamaRequest->watchdog_.start(timeoutMs);
+    } else {
+        ollamaRequest->watchdog_.stop();
+    }
+}
 
-            emit signal_ollamaRequestGotResponse(ollamaResponse);
+void OllamaSystem::startHedge(OllamaRequest *ollamaRequest)
+{
+    if (ollamaRequest->hedgeReply_ || ollamaRequest->receiving_ || !ollamaRequest->reply_) {
+        return;
+    }
+
+    // Only a server of the pool with a free slot gets the duplicate, it must not queue behind other work.
+    QString url = ollamaRequest->getData().getOllamaUrl();
+    if (!endpointPool_->contains(url)) {
+        return;
+    }
+
+    QString hedgeEndpoint;
+    qsizetype fewestRunning = maxParallelRequests_;
+    const QStringList candidates = endpointPool_->getAvailableEndpoints(ollamaRequest->getData().getModel());
+    for (const QString &candidate : candidates) {
+        const EndpointQueue queue = endpointQueues_.value(candidate);
+        if (candidate != ollamaRequest->endpoint_ && queue.pending.isEmpty() && queue.running.size() < fewestRunning) {
+            hedgeEndpoint = candidate;
+            fewestRunning = queue.running.size();
         }
+    }
+    if (hedgeEndpoint.isEmpty()) {
+        return;
+    }
+
+    qDebug() << "ollamasystem is hedging request" << ollamaRequest->getId() << "on" << hedgeEndpoint;
+
+    insertRunning(ollamaRequest, hedgeEndpoint);
+    ollamaRequest->hedgeEndpoint_ = hedgeEndpoint;
+    ollamaRequest->hedgeReply_ = postRequest(ollamaRequest, hedgeEndpoint);
+}
+
+void OllamaSystem::promoteHedge(OllamaRequest *ollamaRequest)
+{
+    QNetworkReply *reply = ollamaRequest->reply_;
+    QString endpoint = ollamaRequest->endpoint_;
+
+    ollamaRequest->reply_ = ollamaRequest->hedgeReply_;
+    ollamaRequest->endpoint_ = ollamaRequest->hedgeEndpoint_;
+    ollamaRequest->hedgeReply_ = nullptr;
+    ollamaRequest->hedgeEndpoint_.clear();
+    ollamaRequest->decoder_ = OllamaStreamDecoder();
+    // The hedge was sent later, it gets the whole first token budget.
+    ollamaRequest->timedOut_ = false;
+    if (!ollamaRequest->receiving_) {
+        armWatchdog(ollamaRequest, OllamaResponse::FirstTokenTimeoutError);
+    }
+
+    endpointQueues_[endpoint].running.removeOne(ollamaRequest);
+    reply->disconnect(ollamaRequest);
+    if (reply->isRunning()) {
+        reply->abort();
+    }
+    reply->deleteLater();
+
+    scheduleRequests(endpoint);
+}
+
+void OllamaSystem::dropHedge(OllamaRequest *ollamaRequest)
+{
+    QNetworkReply *reply = ollamaRequest->hedgeReply_;
+    QString endpoint = ollamaRequest->hedgeEndpoint_;
+
+    ollamaRequest->hedgeReply_ = nullptr;
+    ollamaRequest->hedgeEndpoint_.clear();
+
+    endpointQueues_[endpoint].running.removeOne(ollamaRequest);
+    reply->disconnect(ollamaRequest);
+    if (reply->isRunning()) {
+        reply->abort();
+    }
+    reply->deleteLater();
+
+    scheduleRequests(endpoint);
+}
+
+qint64 OllamaSystem::getHedgeDelay() const
+{
+    if (hedgePercentile_ <= 0 || endpointPool_->getEndpoints().size() < 2 || firstTokenLatencies_.size() < MinFirstTokenLatencies) {
+        return -1;
+    }
+
+    QList<qint64> latencies = firstTokenLatencies_;
+    qsizetype index = std::min(latencies.size() - 1, latencies.size() * hedgePercentile_ / 100);
+    std::nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+    return latencies.at(index);
+}
+
+bool OllamaSystem::retryRequest(OllamaRequest *ollamaRequest, QNetworkReply *reply)
+{
+    if (ollamaRequest->cancelled_ || ollamaRequest->preempted_ || ollamaRequest->receiving_ || ollamaRequest->retries_ >= MaxRetries) {
+        return false;
+    }
+
+    if (ollamaRequest->timedOut_) {
+        // A server which is loading a model or stalls is not helped by asking again.
+        if (ollamaRequest->watchdogError_ != OllamaResponse::ConnectTimeoutError) {
+            return false;
+        }
+        endpointPool_->reportFailure(ollamaRequest->endpoint_);
+    } else {
+        switch (reply->error()) {
+        case QNetworkReply::ConnectionRefusedError:
+        case QNetworkReply::RemoteHostClosedError:
+        case QNetworkReply::HostNotFoundError:
+        case QNetworkReply::TimeoutError:
+        case QNetworkReply::TemporaryNetworkFailureError:
+        case QNetworkReply::NetworkSessionFailedError:
+        case QNetworkReply::UnknownNetworkError:
+            // Other servers of the pool take the retry while this one is down.
+            endpointPool_->reportFailure(ollamaRequest->endpoint_);
+            break;
+        case QNetworkReply::ServiceUnavailableError:
+            // Ollama answers 503 when its queue is full, the server itself is fine.
+            break;
+        default:
+            return false;
+        }
+    }
+
+    // Equal jitter: half of the exponential delay is fixed, the other half random, so retries of many requests spread out.
+    int delay = std::min(RetryBaseDelayMs << ollamaRequest->retries_, RetryMaxDelayMs);
+    delay = delay / 2 + int(QRandomGenerator::global()->bounded(delay / 2 + 1));
+    ++ollamaRequest->retries_;
+    ollamaRequest->timedOut_ = false;
+
+    qDebug() << "ollamasystem retries request" << ollamaRequest->getId() << "in" << delay << "ms after:" << reply->errorString();
+
+    ollamaRequest->decoder_ = OllamaStreamDecoder();
+    QTimer::singleShot(delay, ollamaRequest, [this, ollamaRequest]() {
+        queueRequest(ollamaRequest);
     });
+    return true;
+}
 
-    connect(reply, &QNetworkReply::finished, this, [=, this]() {
-        OllamaResponse ollamaResponse;
+void OllamaSystem::replayRequest(OllamaRequest *ollamaRequest, OllamaResponse cachedResponse)
+{
+    // The caller connects to the handle after it is returned, so nothing may be emitted before that.
+    QTimer::singleShot(0, ollamaRequest, [this, ollamaRequest, cachedResponse]() mutable {
+        // Cancelled before the replay, which already finished the request.
+        if (ollamaRequest->cancelled_) {
+            return;
+        }
+
+        ollamaRequest->metaDataEmitted_ = true;
+        OllamaResponse metaDataResponse;
+        metaDataResponse.setRequestId(ollamaRequest->getId());
+        metaDataResponse.setReceiver(ollamaRequest->getData().getSender());
+        emit ollamaRequest->signal_metaDataChanged(metaDataResponse);
+
+        OllamaResponse &finalResponse = ollamaRequest->finalResponse_;
+        if (!cachedResponse.getResponseText().isEmpty()) {
+            finalResponse.setTimeToFirstToken(ollamaRequest->created_.elapsed());
+            ollamaRequest->streaming_ = true;
+            finalResponse.appendResponseText(cachedResponse.getResponseText());
+
+            OllamaResponse ollamaResponse;
+            ollamaResponse.setRequestId(ollamaRequest->getId());
+            ollamaResponse.setReceiver(finalResponse.getReceiver());
+            ollamaResponse.setResponseText(cachedResponse.getResponseText());
+            emit ollamaRequest->signal_gotResponse(ollamaResponse);
+        }
+
+        finalResponse.setDone(true);
+        finalResponse.setDoneReason(cachedResponse.getDoneReason());
+        finalResponse.setContext(cachedResponse.getContext());
+        finalResponse.setSimilarity(cachedResponse.getSimilarity());
+        finishRequest(ollamaRequest);
+    });
+}
+
+void OllamaSystem::handleReplyFinished(OllamaRequest *ollamaRequest, QNetworkReply *reply)
+{
+    if (reply == ollamaRequest->hedgeReply_) {
+        // The hedge failed before it streamed, the original reply carries on.
+        dropHedge(ollamaRequest);
+        return;
+    }
+
+    ollamaRequest->hedgeTimer_.stop();
+    ollamaRequest->watchdog_.stop();
+    if (ollamaRequest->hedgeReply_) {
+        bool failed = reply->error() != QNetworkReply::NoError && !ollamaRequest->receiving_;
+        if (failed && !ollamaRequest->cancelled_ && !ollamaRequest->preempted_ && !ollamaRequest->requeued_) {
+            // The original reply failed before it streamed, the hedge carries on.
+            promoteHedge(ollamaRequest);
+            return;
+        }
+        dropHedge(ollamaRequest);
+    }
+
+    QString endpoint = ollamaRequest->endpoint_;
+
+    endpointQueues_[endpoint].running.removeOne(ollamaRequest);
+    ollamaRequest->reply_ = nullptr;
+    reply->deleteLater();
+
+    if (ollamaRequest->requeued_) {
+        // Preempted before it produced any text. The caller which preempted it schedules the endpoint.
+        ollamaRequest->requeued_ = false;
+        ollamaRequest->receiving_ = false;
+        ollamaRequest->decoder_ = OllamaStreamDecoder();
+        enqueueRequest(ollamaRequest, true);
+        return;
+    }
+
+    if (retryRequest(ollamaRequest, reply)) {
+        scheduleRequests(endpoint);
+        return;
+    }
+
+    processStreamRecords(ollamaRequest, ollamaRequest->decoder_.feed(reply->readAll()));
+    processStreamRecords(ollamaRequest, ollamaRequest->decoder_.finish());
+
+    OllamaResponse &finalResponse = ollamaRequest->finalResponse_;
+    if (ollamaRequest->cancelled_) {
+        finalResponse.setErrorType(OllamaResponse::CancelledError);
+        finalResponse.setErrorMessage(i18n("Request cancelled"));
+    } else if (ollamaRequest->preempted_) {
+        finalResponse.setErrorType(OllamaResponse::PreemptedError);
+        finalResponse.setErrorMessage(i18n("Request stopped to make room for a more urgent one"));
+    } else if (ollamaRequest->timedOut_) {
+        finalResponse.setErrorType(ollamaRequest->watchdogError_);
+        switch (ollamaRequest->watchdogError_) {
+        case OllamaResponse::ConnectTimeoutError:
+            finalResponse.setErrorMessage(i18n("Could not reach %1 within %2 seconds", endpoint, connectTimeoutMs_ / 1000));
+            break;
+        case OllamaResponse::FirstTokenTimeoutError:
+            finalResponse.setErrorMessage(i18n("The model did not start answering within %1 seconds", firstTokenTimeoutMs_ / 1000));
+            break;
+        default:
+            finalResponse.setErrorMessage(i18n("The model stopped answering for %1 seconds", stallTimeoutMs_ / 1000));
+            break;
+        }
+    } else if (reply->error() != QNetworkReply::NoError && finalResponse.getErrorType() == OllamaResponse::NoError) {
+        // HTTP errors from Ollama carry an error record, which is more telling than the reply's error string.
+        finalResponse.setErrorType(OllamaResponse::NetworkError);
+        finalResponse.setErrorMessage(reply->errorString());
+    }
+
+    if (finalResponse.getErrorType() != OllamaResponse::CancelledError && !finalResponse.getErrorMessage().isEmpty()) {
+        qDebug() << "Error:" << finalResponse.getErrorMessage();
+        qDebug() << "Model:" << ollamaRequest->getData().getModel();
+        qDebug() << "System prompt:" << ollamaRequest->getData().getSystemPrompt();
+    }
+
+    // Only complete answers are cached, the key leaves out who asked and how urgently.
+    if (responseCacheEnabled_ && finalResponse.getErrorType() == OllamaResponse::NoError && finalResponse.isDone()
+        && OllamaResponseCache::isCacheable(ollamaRequest->getData())) {
+        responseCache_.insert(ollamaRequest->getData().getCacheKey(), finalResponse);
+    }
+    if (!ollamaRequest->embedding_.empty() && finalResponse.getErrorType() == OllamaResponse::NoError && finalResponse.isDone()) {
+        semanticCache_.insert(OllamaSemanticCache::getPartitionKey(ollamaRequest->getData()), ollamaRequest->embedding_, finalResponse);
+    }
+
+    finishRequest(ollamaRequest);
+    scheduleRequests(endpoint);
+}
+
+void OllamaSystem::finishRequest(OllamaRequest *request)
+{
+    requests_.remove(request->getId());
+
+    OllamaResponse &finalResponse = request->finalResponse_;
+    finalResponse.setLatency(request->created_.elapsed());
+    if (finalResponse.getErrorType() == OllamaResponse::NoError && finalResponse.isDone()) {
+        emit signal_requestStatistics(request->getData().getModel(), finalResponse);
+    }
+
+    emit request->signal_finished(finalResponse);
+    request->deleteLater();
+}
+
+void OllamaSystem::processStreamRecords(OllamaRequest *request, const QList<QJsonObject> &records)
+{
+    OllamaResponse &finalResponse = request->finalResponse_;
+
+    for (const QJsonObject &record : records) {
+        if (record.contains(QLatin1String("error"))) {
+            finalResponse.setErrorType(OllamaResponse::ServerError);
+            finalResponse.setErrorMessage(record.value(QLatin1String("error")).toString());
+            continue;
+        }
+
+        // /api/generate streams a response field, /api/chat a message object.
+        QString responseText = record.contains(QLatin1String("message"))
+            ? record.value(QLatin1String("message")).toObject().value(QLatin1String("content")).toString()
+            : record.value(QLatin1String("response")).toString();
+        if (!responseText.isEmpty()) {
+            if (!request->streaming_) {
+                finalResponse.setTimeToFirstToken(request->created_.elapsed());
+            }
+            request->streaming_ = true;
+            finalResponse.appendResponseText(responseText);
+
+            OllamaResponse ollamaResponse;
+
+            ollamaResponse.setRequestId(request->getId());
+            ollamaResponse.setReceiver(finalResponse.getReceiver());
+            ollamaResponse.setResponseText(responseText);
+
+            emit request->signal_gotResponse(ollamaResponse);
+        }
+
+        // The final record carries the statistics of the request and no more text.
+        if (record.value(QLatin1String("done")).toBool()) {
+            finalResponse.setDone(true);
+            finalResponse.setDoneReason(record.value(QLatin1String("done_reason")).toString());
+
+            const QJsonArray contextArray = record.value(QLatin1String("context")).toArray();
+            QList<qint64> context;
+            context.reserve(contextArray.size());
+            for (const QJsonValue &token : contextArray) {
+                context.append(token.toInteger());
+            }
+            finalResponse.setContext(context);
+
+            finalResponse.setTotalDuration(record.value(QLatin1String("total_duration")).toInteger());
+            finalResponse.setLoadDuration(record.value(QLatin1String("load_duration")).toInteger());
+            finalResponse.setPromptEvalCount(record.value(QLatin1String("prompt_eval_count")).toInteger());
+            finalResponse.setPromptEvalDuration(record.value(QLatin1String("prompt_eval_duration")).toInteger());
+            finalResponse.setEvalCount(record.value(QLatin1String("eval_count")).toInteger());
+            finalResponse.setEvalDuration(record.value(QLatin1String("eval_duration")).toInteger());
+        }
+    }
+}
+
+void OllamaSystem::fetchModelInfo(OllamaData ollamaData)
+{
+    QString key = ollamaData.getOllamaUrl() + QLatin1Char('\n') + ollamaData.getModel();
+    if (ollamaData.getModel().isEmpty() || contextLengths_.contains(key)) {
+        return;
+    }
+    // Marks the fetch as running, the default is used until it is done.
+    contextLengths_.insert(key, DefaultContextLength);
+
+    QNetworkRequest request = createRequest(ollamaData.getOllamaUrl(), QStringLiteral("/api/show"));
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+
+    QJsonObject json{{"model", ollamaData.getModel()}};
+    QNetworkReply *reply = networkManager_->post(request, QJsonDocument(json).toJson(QJsonDocument::Compact));
+
+    connect(reply, &QNetworkReply::finished, this, [this, reply, key]() {
+        reply->deleteLater();
 
         if (reply->error() != QNetworkReply::NoError) {
-            ollamaResponse.setErrorMessage(reply->errorString());
+            qWarning() << "Error fetching model info:" << reply->errorString();
+            contextLengths_.remove(key);
+            return;
+        }
+
+        QJsonObject jsonObj = QJsonDocument::fromJson(reply->readAll()).object();
 
-            qDebug() << "Error:" << reply->errorString();
-            qDebug() << "Model:" << ollamaData.getModel();
-            qDebug() << "System prompt:" << ollamaData.getSystemPrompt();
+        // Ollama runs a model with num_ctx tokens, which defaults to far less than what the model was trained on.
+        int contextLength = DefaultContextLength;
+        const QStringList parameters = jsonObj.value(QLatin1String("parameters")).toString().split(QLatin1Char('\n'));
+        for (const QString &parameter : parameters) {
+            QStringList keyValue = parameter.simplified().split(QLatin1Char(' '));
+            if (keyValue.size() == 2 && keyValue.at(0) == QLatin1String("num_ctx")) {
+                contextLength = keyValue.at(1).toInt();
+            }
         }
 
-        QString sender = ollamaData.getSender();
+        const QJsonObject modelInfo = jsonObj.value(QLatin1String("model_info")).toObject();
+        for (auto it = modelInfo.begin(); it != modelInfo.end(); ++it) {
+            if (it.key().endsWith(QLatin1String(".context_length"))) {
+                contextLength = qMin(contextLength, it.value().toInt());
+            }
+        }
+
+        contextLengths_.insert(key, qMax(contextLength, 256));
+    });
+}
 
-        ollamaResponse.setReceiver(sender);
+int OllamaSystem::getContextLength(const QString &url, const QString &model) const
+{
+    return contextLengths_.value(url + QLatin1Char('\n') + model, DefaultContextLength);
+}
 
-        emit signal_ollamaRequestFinished(ollamaResponse);
+void OllamaSystem::preloadModel(OllamaData ollamaData)
+{
+    QString key = ollamaData.getOllamaUrl() + QLatin1Char('\n') + ollamaData.getModel();
+    if (ollamaData.getModel().isEmpty() || preloading_.contains(key)) {
+        return;
+    }
+    preloading_.insert(key);
+
+    QNetworkRequest request = createRequest(ollamaData.getOllamaUrl(), QStringLiteral("/api/generate"));
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+
+    // Without a prompt Ollama only loads the model.
+    QJsonObject json{{"model", ollamaData.getModel()}};
+    QJsonObject dataJson = ollamaData.toJson();
+    if (dataJson.contains(QLatin1String("keep_alive"))) {
+        json.insert("keep_alive", dataJson.value(QLatin1String("keep_alive")));
+    }
+    QNetworkReply *reply = networkManager_->post(request, QJsonDocument(json).toJson(QJsonDocument::Compact));
+
+    connect(reply, &QNetworkReply::finished, this, [this, reply, key]() {
         reply->deleteLater();
+        preloading_.remove(key);
+
+        if (reply->error() != QNetworkReply::NoError) {
+            qWarning() << "Error preloading model:" << reply->errorString();
+        }
     });
 }
 
-QString OllamaSystem::getPromptFromText(QString text)
+void OllamaSystem::preconnect(const QString &url)
+{
+    QUrl qUrl(url);
+    if (!qUrl.isValid() || qUrl.host().isEmpty() || url == preconnectedUrl_) {
+        return;
+    }
+    preconnectedUrl_ = url;
+
+#if QT_CONFIG(ssl)
+    if (qUrl.scheme() == QStringLiteral("https")) {
+        networkManager_->connectToHostEncrypted(qUrl.host(), qUrl.port(443));
+        return;
+    }
+#endif
+    networkManager_->connectToHost(qUrl.host(), qUrl.port(80));
+}
+
+QNetworkRequest OllamaSystem::createRequest(const QString &url, const QString &path) const
 {
-    QRegularExpression re("// AI:(.*)");
-    QRegularExpressionMatchIterator matchIterator = re.globalMatch(text);
+    QNetworkRequest request(QUrl(url + path));
+    // Keep the connection in the manager's pool once the response is read, so the next prompt skips the handshake.
+    request.setRawHeader("Connection", "keep-alive");
 
-    QString lastMatch;
+    return request;
+}
 
-    while (matchIterator.hasNext()) {
-        QRegularExpressionMatch match = matchIterator.next();
-        lastMatch = match.captured(1).trimmed();
+QString OllamaSystem::getPromptFromText(QString text)
+{
+    // Only the last marker is used, so search backwards instead of matching every marker in the text.
+    static const QString marker = QStringLiteral("// AI:");
+
+    qsizetype position = text.lastIndexOf(marker);
+    if (position == -1) {
+        return QString();
     }
+    position += marker.size();
+
+    qsizetype lineEnd = text.indexOf(QLatin1Char('\n'), position);
+    QString lastMatch = QStringView(text).sliced(position, (lineEnd == -1 ? text.size() : lineEnd) - position).trimmed().toString();
     qDebug() << "Ollama prompt:" << lastMatch;
 
     return lastMatch;
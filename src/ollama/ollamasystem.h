@@ -6,11 +6,21 @@
 #ifndef OLLAMASYSTEM_H
 #define OLLAMASYSTEM_H
 
+#include <QElapsedTimer>
+#include <QHash>
 #include <QJsonArray>
+#include <QNetworkRequest>
 #include <QObject>
+#include <QSet>
 
 #include "src/ollama/ollamadata.h"
+#include "src/ollama/ollamaendpointpool.h"
+#include "src/ollama/ollamarequest.h"
 #include "src/ollama/ollamaresponse.h"
+#include "src/ollama/ollamaresponsecache.h"
+#include "src/ollama/ollamasemanticcache.h"
+
+class QNetworkAccessManager;
 
 class OllamaSystem : public QObject
 {
@@ -20,21 +30,181 @@ public:
     OllamaSystem(QObject *parent);
     ~OllamaSystem();
 
+    // Refreshes the cached model list of the endpoint when it is missing or older than the TTL.
+    // signal_modelsListLoaded is emitted when the list changed. Only one fetch per endpoint runs at a time.
     void fetchModels(OllamaData ollamaData);
-    void ollamaRequest(OllamaData data);
+    // Gets the cached model list of the endpoint, which may be empty or stale. Call fetchModels to revalidate it.
+    QList<QJsonValue> getModels(const QString &url) const;
+    // Fetches the context window of the model with /api/show, unless it is already known.
+    void fetchModelInfo(OllamaData ollamaData);
+    // Gets the number of tokens the model runs with (num_ctx). A conservative default is returned until it was fetched.
+    int getContextLength(const QString &url, const QString &model) const;
+
+    // Sets whether answers to deterministic requests are cached and replayed. Default is true.
+    void setResponseCacheEnabled(bool responseCacheEnabled);
+    // Gets whether answers to deterministic requests are cached and replayed. Default is true.
+    bool isResponseCacheEnabled() const;
+
+    // Sets whether prompts which allow it are embedded with the embedding model first, to be answered with
+    // the answer to a similar earlier prompt. Default is false.
+    void setSemanticCacheEnabled(bool semanticCacheEnabled);
+    // Gets whether prompts which allow it are embedded with the embedding model first, to be answered with
+    // the answer to a similar earlier prompt. Default is false.
+    bool isSemanticCacheEnabled() const;
+    // Sets the cosine similarity from which an earlier answer is replayed. Default is 0.92.
+    void setSemanticCacheThreshold(float semanticCacheThreshold);
+    // Gets the cosine similarity from which an earlier answer is replayed. Default is 0.92.
+    float getSemanticCacheThreshold() const;
+    // Sets the model used by /api/embed for the semantic cache, e.g. nomic-embed-text.
+    void setEmbeddingModel(const QString &embeddingModel);
+    // Gets the model used by /api/embed for the semantic cache, e.g. nomic-embed-text.
+    QString getEmbeddingModel() const;
+
+    // Schedules a request and returns its handle. Connect to the handle to receive the response,
+    // it is deleted after it emitted signal_finished.
+    // Requests wait in a queue per endpoint, ordered by OllamaData::getPriority().
+    // A cached answer is replayed through the same signals from the event loop, without a request to Ollama.
+    OllamaRequest *ollamaRequest(OllamaData data);
+    // Gets a running request by its id, or nullptr when it already finished.
+    OllamaRequest *getRequest(quint64 requestId) const;
+    // Stops a queued or running request. The connection is closed, which makes Ollama stop generating and free its slot.
+    // The request still emits signal_finished, with the CancelledError error type.
+    void cancelRequest(quint64 requestId);
+    // Changes the priority of a queued or running request, for example when a background request turns out to be needed now.
+    void setRequestPriority(quint64 requestId, OllamaData::Priority priority);
+
+    // Sets how many requests may run at the same time on one endpoint. Default is 1, like OLLAMA_NUM_PARALLEL.
+    void setMaxParallelRequests(int maxParallelRequests);
+    // Gets how many requests may run at the same time on one endpoint. Default is 1, like OLLAMA_NUM_PARALLEL.
+    int getMaxParallelRequests() const;
+
+    // Sets how long a request may take to reach the server, in milliseconds. 0 waits forever. Default is 5 seconds.
+    void setConnectTimeout(int connectTimeoutMs);
+    // Gets how long a request may take to reach the server, in milliseconds. 0 waits forever. Default is 5 seconds.
+    int getConnectTimeout() const;
+    // Sets how long the server may take to send the first token, model load included, in milliseconds. 0 waits forever.
+    // Default is 90 seconds.
+    void setFirstTokenTimeout(int firstTokenTimeoutMs);
+    // Gets how long the server may take to send the first token, model load included, in milliseconds. 0 waits forever.
+    // Default is 90 seconds.
+    int getFirstTokenTimeout() const;
+    // Sets how long the server may go quiet in the middle of an answer, in milliseconds. 0 waits forever. Default is 20 seconds.
+    void setStallTimeout(int stallTimeoutMs);
+    // Gets how long the server may go quiet in the middle of an answer, in milliseconds. 0 waits forever. Default is 20 seconds.
+    int getStallTimeout() const;
+
+    // Sets after which percentile of the recent times to first token a request is also sent to a second endpoint.
+    // Whichever reply streams first is kept. 0 turns hedging off, which is the default.
+    void setHedgePercentile(int hedgePercentile);
+    // Gets after which percentile of the recent times to first token a request is also sent to a second endpoint.
+    int getHedgePercentile() const;
+
+    // Sets the Ollama servers requests are spread over. Requests for one of these urls go to the healthy server
+    // with the model and the fewest outstanding requests. Empty, or a single url, turns balancing off.
+    void setEndpoints(const QStringList &urls);
+    // Gets the Ollama servers requests are spread over.
+    QStringList getEndpoints() const;
+    // Gets whether the endpoint answered its last health check.
+    bool isEndpointHealthy(const QString &url) const;
+
     QString getPromptFromText(QString text);
 
-signals:
-    void signal_modelsListLoaded(const QList<QJsonValue> &modelsList);
-    void signal_errorFetchingModelsList(QString error);
+    // Loads the model into memory with an empty /api/generate request, so the first prompt does not wait for it.
+    // The keep alive of the data says how long it stays loaded. Only one warm-up per endpoint and model runs at a time.
+    void preloadModel(OllamaData ollamaData);
 
-    void signal_ollamaRequestMetaDataChanged(OllamaResponse ollamaResponse);
-    void signal_ollamaRequestGotResponse(OllamaResponse ollamaResponse);
-    void signal_ollamaRequestFinished(OllamaResponse ollamaResponse);
+    // Opens a keep-alive connection to the given endpoint ahead of the first request,
+    // so the TCP (and TLS) handshake is not part of the time to first token.
+    void preconnect(const QString &url);
+
+signals:
+    void signal_modelsListLoaded(const QString &url, const QList<QJsonValue> &modelsList);
+    void signal_errorFetchingModelsList(const QString &url, QString error);
+    // Emitted for every request which completed, with Ollama's timings and the client-measured ones, for statistics.
+    void signal_requestStatistics(const QString &model, OllamaResponse ollamaResponse);
 
 private:
+    // The model list of one endpoint, shared by all tabs, views and the config page.
+    struct ModelsCacheEntry {
+        QList<QJsonValue> models;
+        QElapsedTimer age;
+        QNetworkReply *reply = nullptr;
+    };
+
+    // The requests of one endpoint. Both lists are ordered from high to low priority.
+    struct EndpointQueue {
+        QList<OllamaRequest *> pending;
+        QList<OllamaRequest *> running;
+    };
+
+    // Adds the request to the pending list of its endpoint, behind (or ahead of) requests with the same priority.
+    void enqueueRequest(OllamaRequest *request, bool aheadOfSamePriority = false);
+    // Starts pending requests of the endpoint while it has free slots.
+    void scheduleRequests(const QString &endpoint);
+    // Frees a slot for the request by stopping lower priority work on its endpoint.
+    void preemptFor(OllamaRequest *request);
+    // Picks the endpoint of the pool with the fewest queued and running requests which can serve the request.
+    // Requests for urls outside the pool stay on their url.
+    QString selectEndpoint(const OllamaRequest *request) const;
+    // Adds a new request to its endpoint queue and starts it when a slot is free.
+    void queueRequest(OllamaRequest *request);
+    // Embeds the prompt of the request, then replays a similar answer or queues the request.
+    void embedRequest(OllamaRequest *request);
+    void startRequest(OllamaRequest *request);
+    // Posts the request to the endpoint and connects its reply. Used for the request itself and for its hedge.
+    QNetworkReply *postRequest(OllamaRequest *request, const QString &endpoint);
+    // Adds the request to the running list of the endpoint, which is ordered from high to low priority.
+    void insertRunning(OllamaRequest *request, const QString &endpoint);
+    void handleReplyReadyRead(OllamaRequest *request, QNetworkReply *reply);
+    // Sends a duplicate of a request which did not answer in time to another endpoint with a free slot.
+    void startHedge(OllamaRequest *request);
+    // Makes the hedge the reply of the request and aborts the original reply.
+    void promoteHedge(OllamaRequest *request);
+    // Aborts the hedge of the request and frees its slot.
+    void dropHedge(OllamaRequest *request);
+    // (Re)starts the watchdog of the request for the given timeout, or stops it when that timeout is turned off.
+    void armWatchdog(OllamaRequest *request, OllamaResponse::ErrorType timeout);
+    // Gets how long a request may wait for its first token before it is hedged, or -1 to not hedge.
+    qint64 getHedgeDelay() const;
+    // Sends the request again after an exponential, jittered delay when its connection failed before it answered.
+    // Returns false when the failure is not worth a retry or the retries are used up.
+    bool retryRequest(OllamaRequest *request, QNetworkReply *reply);
+    // Emits a cached answer on the request as if it was streamed, in one piece.
+    void replayRequest(OllamaRequest *request, OllamaResponse cachedResponse);
+    void handleReplyFinished(OllamaRequest *request, QNetworkReply *reply);
+    // Emits signal_finished on the request and deletes it.
+    void finishRequest(OllamaRequest *request);
+
+    // Emits the text of each streamed record and collects the error and final record of the request.
+    void processStreamRecords(OllamaRequest *request, const QList<QJsonObject> &records);
+    QNetworkRequest createRequest(const QString &url, const QString &path) const;
+
     QObject *parent = nullptr;
-    QList<QJsonValue> m_modelsList;
+    // Shared by all requests. Qt pools keep-alive connections per host and port on a single manager.
+    QNetworkAccessManager *networkManager_ = nullptr;
+    QString preconnectedUrl_;
+    QHash<quint64, OllamaRequest *> requests_;
+    quint64 nextRequestId_ = 1;
+    QHash<QString, EndpointQueue> endpointQueues_;
+    int maxParallelRequests_ = 1;
+    OllamaEndpointPool *endpointPool_ = nullptr;
+    int connectTimeoutMs_ = 5000;
+    int firstTokenTimeoutMs_ = 90000;
+    int stallTimeoutMs_ = 20000;
+    int hedgePercentile_ = 0;
+    // Recent times to first token in milliseconds, oldest first.
+    QList<qint64> firstTokenLatencies_;
+    QHash<QString, ModelsCacheEntry> modelsCache_;
+    OllamaResponseCache responseCache_;
+    bool responseCacheEnabled_ = true;
+    OllamaSemanticCache semanticCache_;
+    bool semanticCacheEnabled_ = false;
+    float semanticCacheThreshold_ = 0.92f;
+    QString embeddingModel_;
+    // Context window by endpoint and model.
+    QHash<QString, int> contextLengths_;
+    // Endpoints and models with a warm-up running.
+    QSet<QString> preloading_;
     QStringList m_errors;
     QStringList m_messages;
 };
@@ -0,0 +1,31 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include "src/ollama/ollamatokenestimator.h"
+
+int OllamaTokenEstimator::estimateTokens(QStringView text)
+{
+    int tokens = 0;
+    int wordLength = 0;
+
+    for (QChar c : text) {
+        if (c.isLetterOrNumber() || c == QLatin1Char('_')) {
+            ++wordLength;
+            continue;
+        }
+
+        tokens += (wordLength + 3) / 4;
+        wordLength = 0;
+
+        // Whitespace is mostly merged into the neighbouring tokens.
+        if (!c.isSpace() || c == QLatin1Char('\n')) {
+            ++tokens;
+        }
+    }
+    tokens += (wordLength + 3) / 4;
+
+    return tokens;
+}
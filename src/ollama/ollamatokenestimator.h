@@ -0,0 +1,23 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+#ifndef OLLAMATOKENESTIMATOR_H
+#define OLLAMATOKENESTIMATOR_H
+
+#include <QStringView>
+
+/*
+ * Estimates how many tokens a text costs without calling the model's tokenizer.
+ * Words count as one token per four characters and every symbol as a token of its own,
+ * which is close enough for code and prose to budget a context window.
+ */
+class OllamaTokenEstimator
+{
+public:
+    // Gets the estimated number of tokens of the text.
+    static int estimateTokens(QStringView text);
+};
+
+#endif // OLLAMATOKENESTIMATOR_H
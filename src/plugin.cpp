@@ -29,6 +29,7 @@
 #include <QNetworkReply>
 #include <QNetworkRequest>
 #include <QRegularExpression>
+#include <QStandardPaths>
 #include <QString>
 #include <ktexteditor/message.h>
 #include <qcontainerfwd.h>
@@ -62,6 +63,10 @@ KateOllamaPlugin::KateOllamaPlugin(QObject *parent, const QVariantList &)
     : KTextEditor::Plugin(parent)
 {
     olamaSystem_ = new OllamaSystem(this);
+    ollamaSpeculator_ = new OllamaSpeculator(olamaSystem_, this);
+    ollamaSessionStore_ =
+        new OllamaSessionStore(QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QStringLiteral("/kateollama/sessions"), this);
+    ollamaSearchIndex_ = new OllamaSearchIndex(ollamaSessionStore_, this);
 }
 
 QObject *KateOllamaPlugin::createToolWindow(KTextEditor::MainWindow *mainWindow)
@@ -109,6 +114,51 @@ QString KateOllamaPlugin::getOllamaUrl()
     return ollamaUrl_;
 }
 
+void KateOllamaPlugin::setInlineCompletionEnabled(bool inlineCompletionEnabled)
+{
+    inlineCompletionEnabled_ = inlineCompletionEnabled;
+}
+bool KateOllamaPlugin::isInlineCompletionEnabled()
+{
+    return inlineCompletionEnabled_;
+}
+
+void KateOllamaPlugin::setInlineCompletionModel(QString inlineCompletionModel)
+{
+    inlineCompletionModel_ = inlineCompletionModel;
+}
+QString KateOllamaPlugin::getInlineCompletionModel()
+{
+    return inlineCompletionModel_;
+}
+
+void KateOllamaPlugin::setSpeculativeCompletionEnabled(bool speculativeCompletionEnabled)
+{
+    speculativeCompletionEnabled_ = speculativeCompletionEnabled;
+}
+bool KateOllamaPlugin::isSpeculativeCompletionEnabled()
+{
+    return speculativeCompletionEnabled_;
+}
+
+void KateOllamaPlugin::setSeed(int seed)
+{
+    seed_ = seed;
+}
+int KateOllamaPlugin::getSeed()
+{
+    return seed_;
+}
+
+void KateOllamaPlugin::setKeepAlive(QString keepAlive)
+{
+    keepAlive_ = keepAlive;
+}
+QString KateOllamaPlugin::getKeepAlive()
+{
+    return keepAlive_;
+}
+
 void KateOllamaPlugin::setOllamaData(OllamaData ollamaData)
 {
     ollamaData_ = ollamaData;
@@ -118,4 +168,24 @@ OllamaData KateOllamaPlugin::getOllamaData()
     return ollamaData_;
 }
 
+OllamaSystem *KateOllamaPlugin::getOllamaSystem()
+{
+    return olamaSystem_;
+}
+
+OllamaSpeculator *KateOllamaPlugin::getOllamaSpeculator()
+{
+    return ollamaSpeculator_;
+}
+
+OllamaSessionStore *KateOllamaPlugin::getOllamaSessionStore()
+{
+    return ollamaSessionStore_;
+}
+
+OllamaSearchIndex *KateOllamaPlugin::getOllamaSearchIndex()
+{
+    return ollamaSearchIndex_;
+}
+
 #include <plugin.moc>
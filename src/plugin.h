@@ -9,6 +9,9 @@
 
 // KF headers
 #include "ollama/ollamadata.h"
+#include "ollama/ollamasearchindex.h"
+#include "ollama/ollamasessionstore.h"
+#include "ollama/ollamaspeculator.h"
 #include "ollama/ollamasystem.h"
 #include <KTextEditor/Document>
 #include <KTextEditor/MainWindow>
@@ -46,16 +49,46 @@ public:
     void setOllamaUrl(QString ollamaUrl);
     QString getOllamaUrl();
 
+    void setInlineCompletionEnabled(bool inlineCompletionEnabled);
+    bool isInlineCompletionEnabled();
+
+    void setInlineCompletionModel(QString inlineCompletionModel);
+    QString getInlineCompletionModel();
+
+    void setSpeculativeCompletionEnabled(bool speculativeCompletionEnabled);
+    bool isSpeculativeCompletionEnabled();
+
+    void setSeed(int seed);
+    int getSeed();
+
+    void setKeepAlive(QString keepAlive);
+    QString getKeepAlive();
+
     void setOllamaData(OllamaData ollamaData);
     OllamaData getOllamaData();
 
+    OllamaSystem *getOllamaSystem();
+    OllamaSpeculator *getOllamaSpeculator();
+    OllamaSessionStore *getOllamaSessionStore();
+    OllamaSearchIndex *getOllamaSearchIndex();
+
 private:
     QString model_;
     QString systemPrompt_;
     QString ollamaUrl_;
+    bool inlineCompletionEnabled_ = false;
+    QString inlineCompletionModel_;
+    bool speculativeCompletionEnabled_ = false;
+    // Sent as the seed option when not 0, which makes answers reproducible and so cacheable.
+    int seed_ = 0;
+    // How long Ollama keeps the model loaded after a request, sent as keep_alive.
+    QString keepAlive_;
 
     OllamaData ollamaData_;
     OllamaSystem *olamaSystem_;
+    OllamaSpeculator *ollamaSpeculator_;
+    OllamaSessionStore *ollamaSessionStore_;
+    OllamaSearchIndex *ollamaSearchIndex_;
 };
 
 #endif // KATEOLLAMAPLUGIN_H
@@ -9,20 +9,22 @@
 #include <KSharedConfig>
 #include <KTextEditor/ConfigPage>
 
+#include <QCheckBox>
 #include <QComboBox>
+#include <QDoubleSpinBox>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QLabel>
 #include <QLineEdit>
 #include <QList>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
-#include <QNetworkRequest>
+#include <QSignalBlocker>
+#include <QSpinBox>
 #include <QTextEdit>
 #include <QVBoxLayout>
-#include <algorithm>
 
+#include "src/ollama/ollamadata.h"
+#include "src/ollama/ollamasystem.h"
 #include "src/plugin.h"
 #include "src/settings.h"
 
@@ -45,6 +47,41 @@ KateOllamaConfigPage::KateOllamaConfigPage(QWidget *parent, KateOllamaPlugin *pl
         layout->addLayout(hl);
     }
 
+    // Additional endpoints
+    {
+        auto *hl = new QHBoxLayout;
+
+        auto label = new QLabel(i18n("Additional Ollama URLs"));
+        hl->addWidget(label);
+
+        endpointsText_ = new QLineEdit(this);
+        endpointsText_->setPlaceholderText(i18n("http://gpu-box:11434, http://laptop:11434"));
+        endpointsText_->setToolTip(
+            i18n("Comma separated. Requests are spread over these servers and the Ollama URL, to the server with the model and the fewest requests."));
+        hl->addWidget(endpointsText_);
+
+        layout->addLayout(hl);
+    }
+
+    // Hedging
+    {
+        auto *hl = new QHBoxLayout;
+
+        auto label = new QLabel(i18n("Ask a second server when slower than"));
+        hl->addWidget(label);
+
+        hedgePercentileSpinBox_ = new QSpinBox(this);
+        hedgePercentileSpinBox_->setRange(0, 99);
+        hedgePercentileSpinBox_->setSuffix(i18n(" % of recent requests"));
+        hedgePercentileSpinBox_->setSpecialValueText(i18n("Never"));
+        hedgePercentileSpinBox_->setToolTip(
+            i18n("When the first token takes longer than this percentile of recent requests, the request is also sent to an idle additional server. "
+                 "The first one to answer is kept."));
+        hl->addWidget(hedgePercentileSpinBox_);
+
+        layout->addLayout(hl);
+    }
+
     // Available Models
     {
         auto *hl = new QHBoxLayout;
@@ -58,6 +95,129 @@ KateOllamaConfigPage::KateOllamaConfigPage(QWidget *parent, KateOllamaPlugin *pl
         layout->addLayout(hl);
     }
 
+    // Inline completion model
+    {
+        auto *hl = new QHBoxLayout;
+
+        auto label = new QLabel(i18n("Inline completion model"));
+        hl->addWidget(label);
+
+        inlineCompletionModelComboBox_ = new QComboBox(this);
+        inlineCompletionModelComboBox_->setEditable(true);
+        inlineCompletionModelComboBox_->lineEdit()->setPlaceholderText(i18n("Same as the selected model"));
+        inlineCompletionModelComboBox_->setToolTip(i18n("Ghost text needs a model trained for fill-in-the-middle, such as a coder model."));
+        hl->addWidget(inlineCompletionModelComboBox_);
+
+        layout->addLayout(hl);
+    }
+
+    // Parallel requests
+    {
+        auto *hl = new QHBoxLayout;
+
+        auto label = new QLabel(i18n("Parallel requests per endpoint"));
+        hl->addWidget(label);
+
+        maxParallelRequestsSpinBox_ = new QSpinBox(this);
+        maxParallelRequestsSpinBox_->setRange(1, 16);
+        maxParallelRequestsSpinBox_->setToolTip(i18n("Should match OLLAMA_NUM_PARALLEL of the server. Extra requests wait in a queue, editor requests first."));
+        hl->addWidget(maxParallelRequestsSpinBox_);
+
+        layout->addLayout(hl);
+    }
+
+    // Timeouts
+    {
+        auto *hl = new QHBoxLayout;
+
+        auto label = new QLabel(i18n("Give up when the server does not"));
+        hl->addWidget(label);
+
+        connectTimeoutSpinBox_ = new QSpinBox(this);
+        connectTimeoutSpinBox_->setRange(0, 600);
+        connectTimeoutSpinBox_->setPrefix(i18n("connect in "));
+        connectTimeoutSpinBox_->setSuffix(i18n(" s"));
+        connectTimeoutSpinBox_->setSpecialValueText(i18n("connect: no limit"));
+        hl->addWidget(connectTimeoutSpinBox_);
+
+        firstTokenTimeoutSpinBox_ = new QSpinBox(this);
+        firstTokenTimeoutSpinBox_->setRange(0, 3600);
+        firstTokenTimeoutSpinBox_->setPrefix(i18n("start answering in "));
+        firstTokenTimeoutSpinBox_->setSuffix(i18n(" s"));
+        firstTokenTimeoutSpinBox_->setSpecialValueText(i18n("start answering: no limit"));
+        firstTokenTimeoutSpinBox_->setToolTip(i18n("Includes loading the model"));
+        hl->addWidget(firstTokenTimeoutSpinBox_);
+
+        stallTimeoutSpinBox_ = new QSpinBox(this);
+        stallTimeoutSpinBox_->setRange(0, 600);
+        stallTimeoutSpinBox_->setPrefix(i18n("pause at most "));
+        stallTimeoutSpinBox_->setSuffix(i18n(" s"));
+        stallTimeoutSpinBox_->setSpecialValueText(i18n("pause: no limit"));
+        stallTimeoutSpinBox_->setToolTip(i18n("The longest silence between two tokens of an answer"));
+        hl->addWidget(stallTimeoutSpinBox_);
+
+        layout->addLayout(hl);
+    }
+
+    // Keep alive
+    {
+        auto *hl = new QHBoxLayout;
+
+        auto label = new QLabel(i18n("Keep model loaded for"));
+        hl->addWidget(label);
+
+        keepAliveText_ = new QLineEdit(this);
+        keepAliveText_->setPlaceholderText(i18n("5m"));
+        keepAliveText_->setToolTip(i18n("A duration like 30m or 2h, or seconds. -1 keeps the model loaded, 0 unloads it after every request."));
+        hl->addWidget(keepAliveText_);
+
+        layout->addLayout(hl);
+    }
+
+    // Seed
+    {
+        auto *hl = new QHBoxLayout;
+
+        auto label = new QLabel(i18n("Seed"));
+        hl->addWidget(label);
+
+        seedSpinBox_ = new QSpinBox(this);
+        seedSpinBox_->setRange(0, 999999);
+        seedSpinBox_->setSpecialValueText(i18n("Random"));
+        seedSpinBox_->setToolTip(i18n("With a fixed seed the same question gets the same answer, which can then be cached."));
+        hl->addWidget(seedSpinBox_);
+
+        layout->addLayout(hl);
+    }
+
+    // Response cache
+    {
+        responseCacheCheckBox_ = new QCheckBox(i18n("Cache answers to reproducible requests"), this);
+        responseCacheCheckBox_->setToolTip(i18n("Requests with a fixed seed or a temperature of 0 are answered from memory or disk when asked again."));
+        layout->addWidget(responseCacheCheckBox_);
+    }
+
+    // Semantic cache
+    {
+        auto *hl = new QHBoxLayout;
+
+        semanticCacheCheckBox_ = new QCheckBox(i18n("Answer similar questions from the cache"), this);
+        semanticCacheCheckBox_->setToolTip(i18n("Questions asked in the tool view are embedded first. A question worded like an earlier one gets its answer."));
+        hl->addWidget(semanticCacheCheckBox_);
+
+        embeddingModelText_ = new QLineEdit(this);
+        embeddingModelText_->setPlaceholderText(i18n("Embedding model, e.g. nomic-embed-text"));
+        hl->addWidget(embeddingModelText_);
+
+        semanticCacheThresholdSpinBox_ = new QDoubleSpinBox(this);
+        semanticCacheThresholdSpinBox_->setRange(0.5, 1.0);
+        semanticCacheThresholdSpinBox_->setSingleStep(0.01);
+        semanticCacheThresholdSpinBox_->setToolTip(i18n("How similar a question must be, as cosine similarity of the embeddings"));
+        hl->addWidget(semanticCacheThresholdSpinBox_);
+
+        layout->addLayout(hl);
+    }
+
     // System Prompt
     {
         auto *hl = new QHBoxLayout;
@@ -88,60 +248,90 @@ KateOllamaConfigPage::KateOllamaConfigPage(QWidget *parent, KateOllamaPlugin *pl
     QObject::connect(modelsComboBox_, &QComboBox::currentIndexChanged, this, &KateOllamaConfigPage::changed);
     QObject::connect(systemPromptEdit_, &QTextEdit::textChanged, this, &KateOllamaConfigPage::changed);
     QObject::connect(ollamaURLText_, &QLineEdit::textEdited, this, &KateOllamaConfigPage::changed);
+    QObject::connect(endpointsText_, &QLineEdit::textEdited, this, &KateOllamaConfigPage::changed);
+    QObject::connect(hedgePercentileSpinBox_, &QSpinBox::valueChanged, this, &KateOllamaConfigPage::changed);
+    QObject::connect(connectTimeoutSpinBox_, &QSpinBox::valueChanged, this, &KateOllamaConfigPage::changed);
+    QObject::connect(firstTokenTimeoutSpinBox_, &QSpinBox::valueChanged, this, &KateOllamaConfigPage::changed);
+    QObject::connect(stallTimeoutSpinBox_, &QSpinBox::valueChanged, this, &KateOllamaConfigPage::changed);
+    QObject::connect(inlineCompletionModelComboBox_, &QComboBox::currentTextChanged, this, &KateOllamaConfigPage::changed);
+    QObject::connect(maxParallelRequestsSpinBox_, &QSpinBox::valueChanged, this, &KateOllamaConfigPage::changed);
+    QObject::connect(seedSpinBox_, &QSpinBox::valueChanged, this, &KateOllamaConfigPage::changed);
+    QObject::connect(keepAliveText_, &QLineEdit::textEdited, this, &KateOllamaConfigPage::changed);
+    QObject::connect(responseCacheCheckBox_, &QCheckBox::toggled, this, &KateOllamaConfigPage::changed);
+    QObject::connect(semanticCacheCheckBox_, &QCheckBox::toggled, this, &KateOllamaConfigPage::changed);
+    QObject::connect(embeddingModelText_, &QLineEdit::textEdited, this, &KateOllamaConfigPage::changed);
+    QObject::connect(semanticCacheThresholdSpinBox_, &QDoubleSpinBox::valueChanged, this, &KateOllamaConfigPage::changed);
+    QObject::connect(ollamaURLText_, &QLineEdit::editingFinished, this, [this]() {
+        plugin_->getOllamaSystem()->preconnect(ollamaURLText_->text());
+        fetchModelList();
+    });
+    QObject::connect(plugin_->getOllamaSystem(), &OllamaSystem::signal_modelsListLoaded, this, &KateOllamaConfigPage::handle_modelsListLoaded);
+    QObject::connect(plugin_->getOllamaSystem(), &OllamaSystem::signal_errorFetchingModelsList, this, &KateOllamaConfigPage::handle_errorFetchingModelsList);
 }
 
 void KateOllamaConfigPage::fetchModelList()
 {
-    QNetworkAccessManager *manager = new QNetworkAccessManager(this);
-    connect(manager, &QNetworkAccessManager::finished, this, [this](QNetworkReply *reply) {
-        if (reply->error() == QNetworkReply::NoError) {
-            infoLabel_->setVisible(false); // Hide the label on success
-
-            QByteArray responseData = reply->readAll();
-            QJsonDocument jsonDoc = QJsonDocument::fromJson(responseData);
-
-            if (jsonDoc.isObject()) {
-                QJsonObject jsonObj = jsonDoc.object();
-                if (jsonObj.contains("models") && jsonObj["models"].isArray()) {
-                    QJsonArray modelsArray = jsonObj["models"].toArray();
-                    QList<QJsonValue> modelsList;
-                    for (const QJsonValue &value : modelsArray) {
-                        modelsList.append(value);
-                    }
-                    std::sort(modelsList.begin(), modelsList.end(), [](const QJsonValue &a, const QJsonValue &b) {
-                        return a.toObject()["name"].toString().toLower() < b.toObject()["name"].toString().toLower();
-                    });
-
-                    int modelSelected = -1;
-                    for (const QJsonValue &modelValue : modelsList) {
-                        QJsonObject modelObj = modelValue.toObject();
-                        if (modelObj.contains("name")) {
-                            modelsComboBox_->addItem(modelObj["name"].toString());
-                        }
-
-                        if (modelObj["name"].toString() == plugin_->getModel()) {
-                            modelSelected = modelsComboBox_->count();
-                        }
-                    }
-
-                    if (modelSelected != -1) {
-                        modelsComboBox_->setCurrentIndex(modelSelected - 1);
-                    }
-                }
-            }
-        } else {
-            qWarning() << "Error fetching model list:" << reply->errorString();
-            // Show error in UI
-            infoLabel_->setText(i18n("Error fetching model list: %1", reply->errorString()));
+    OllamaData ollamaData;
+    ollamaData.setOllamaUrl(ollamaURLText_->text());
+
+    QList<QJsonValue> modelsList = plugin_->getOllamaSystem()->getModels(ollamaData.getOllamaUrl());
+    if (!modelsList.isEmpty()) {
+        handle_modelsListLoaded(ollamaData.getOllamaUrl(), modelsList);
+    } else {
+        infoLabel_->setText(i18n("Loading model list..."));
+        infoLabel_->setVisible(true);
+    }
+
+    plugin_->getOllamaSystem()->fetchModels(ollamaData);
+}
+
+void KateOllamaConfigPage::handle_modelsListLoaded(const QString &url, const QList<QJsonValue> &modelsList)
+{
+    if (url != ollamaURLText_->text()) {
+        return;
+    }
+
+    infoLabel_->setVisible(false); // Hide the label on success
+
+    QString selectedModel = modelsComboBox_->currentText();
+    if (selectedModel.isEmpty()) {
+        selectedModel = plugin_->getModel();
+    }
+
+    QSignalBlocker blocker(modelsComboBox_);
+    modelsComboBox_->clear();
+
+    for (const QJsonValue &modelValue : modelsList) {
+        QJsonObject modelObj = modelValue.toObject();
+        if (modelObj.contains("name")) {
+            modelsComboBox_->addItem(modelObj["name"].toString());
         }
-        reply->deleteLater();
-    });
+    }
 
-    QUrl url(ollamaURLText_->text() + "/api/tags");
-    QNetworkRequest request(url);
-    manager->get(request);
+    int modelSelected = modelsComboBox_->findText(selectedModel);
+    if (modelSelected != -1) {
+        modelsComboBox_->setCurrentIndex(modelSelected);
+    }
 
-    infoLabel_->setText(i18n("Loading model list..."));
+    // The inline completion model may be typed in, so its text is kept as is.
+    QSignalBlocker inlineBlocker(inlineCompletionModelComboBox_);
+    QString inlineCompletionModel = inlineCompletionModelComboBox_->currentText();
+    inlineCompletionModelComboBox_->clear();
+    inlineCompletionModelComboBox_->addItem(QString());
+    for (int i = 0; i < modelsComboBox_->count(); ++i) {
+        inlineCompletionModelComboBox_->addItem(modelsComboBox_->itemText(i));
+    }
+    inlineCompletionModelComboBox_->setCurrentText(inlineCompletionModel);
+}
+
+void KateOllamaConfigPage::handle_errorFetchingModelsList(const QString &url, const QString &error)
+{
+    if (url != ollamaURLText_->text()) {
+        return;
+    }
+
+    // Show error in UI
+    infoLabel_->setText(error);
     infoLabel_->setVisible(true);
 }
 
@@ -166,18 +356,64 @@ void KateOllamaConfigPage::apply()
     KConfigGroup group(KSharedConfig::openConfig(), "KateOllama");
     group.writeEntry("Model", modelsComboBox_->currentText());
     group.writeEntry("URL", ollamaURLText_->text());
+    group.writeEntry("Endpoints", getEndpoints());
+    group.writeEntry("HedgePercentile", hedgePercentileSpinBox_->value());
+    group.writeEntry("ConnectTimeout", connectTimeoutSpinBox_->value());
+    group.writeEntry("FirstTokenTimeout", firstTokenTimeoutSpinBox_->value());
+    group.writeEntry("StallTimeout", stallTimeoutSpinBox_->value());
     group.writeEntry("SystemPrompt", systemPromptEdit_->toPlainText());
+    group.writeEntry("InlineCompletionModel", inlineCompletionModelComboBox_->currentText());
+    group.writeEntry("MaxParallelRequests", maxParallelRequestsSpinBox_->value());
+    group.writeEntry("Seed", seedSpinBox_->value());
+    group.writeEntry("KeepAlive", keepAliveText_->text());
+    group.writeEntry("ResponseCache", responseCacheCheckBox_->isChecked());
+    group.writeEntry("SemanticCache", semanticCacheCheckBox_->isChecked());
+    group.writeEntry("EmbeddingModel", embeddingModelText_->text());
+    group.writeEntry("SemanticCacheThreshold", semanticCacheThresholdSpinBox_->value());
     group.sync();
 
     // Update the cached variables in Plugin
     plugin_->setModel(modelsComboBox_->currentText());
-    plugin_->setModel(systemPromptEdit_->toPlainText());
+    plugin_->setSystemPrompt(systemPromptEdit_->toPlainText());
     plugin_->setOllamaUrl(ollamaURLText_->text());
+    plugin_->setKeepAlive(keepAliveText_->text());
+    plugin_->setInlineCompletionModel(inlineCompletionModelComboBox_->currentText());
+    plugin_->setSeed(seedSpinBox_->value());
+    plugin_->getOllamaSystem()->setMaxParallelRequests(maxParallelRequestsSpinBox_->value());
+    plugin_->getOllamaSystem()->setEndpoints(QStringList{ollamaURLText_->text()} + getEndpoints());
+    plugin_->getOllamaSystem()->setHedgePercentile(hedgePercentileSpinBox_->value());
+    plugin_->getOllamaSystem()->setConnectTimeout(connectTimeoutSpinBox_->value() * 1000);
+    plugin_->getOllamaSystem()->setFirstTokenTimeout(firstTokenTimeoutSpinBox_->value() * 1000);
+    plugin_->getOllamaSystem()->setStallTimeout(stallTimeoutSpinBox_->value() * 1000);
+    plugin_->getOllamaSystem()->setResponseCacheEnabled(responseCacheCheckBox_->isChecked());
+    plugin_->getOllamaSystem()->setSemanticCacheEnabled(semanticCacheCheckBox_->isChecked());
+    plugin_->getOllamaSystem()->setEmbeddingModel(embeddingModelText_->text());
+    plugin_->getOllamaSystem()->setSemanticCacheThreshold(semanticCacheThresholdSpinBox_->value());
+
+    // Load the chosen model now instead of with the first prompt.
+    OllamaData ollamaData;
+    ollamaData.setOllamaUrl(plugin_->getOllamaUrl());
+    ollamaData.setModel(plugin_->getModel());
+    ollamaData.setKeepAlive(plugin_->getKeepAlive());
+    plugin_->getOllamaSystem()->preloadModel(ollamaData);
 }
 
 void KateOllamaConfigPage::defaults()
 {
     ollamaURLText_->setText("http://localhost:11434");
+    endpointsText_->clear();
+    hedgePercentileSpinBox_->setValue(0);
+    connectTimeoutSpinBox_->setValue(5);
+    firstTokenTimeoutSpinBox_->setValue(90);
+    stallTimeoutSpinBox_->setValue(20);
+    inlineCompletionModelComboBox_->setCurrentText(QString());
+    maxParallelRequestsSpinBox_->setValue(1);
+    seedSpinBox_->setValue(0);
+    keepAliveText_->setText("30m");
+    responseCacheCheckBox_->setChecked(true);
+    semanticCacheCheckBox_->setChecked(false);
+    embeddingModelText_->setText("nomic-embed-text");
+    semanticCacheThresholdSpinBox_->setValue(0.92);
     systemPromptEdit_->setPlainText(
         "You are a smart coder assistant, code comments are in the prompt language. You don't explain, you add only code comments.");
 }
@@ -188,6 +424,34 @@ void KateOllamaConfigPage::reset()
     modelsComboBox_->setCurrentText(plugin_->getModel());
     systemPromptEdit_->setPlainText(plugin_->getSystemPrompt());
     ollamaURLText_->setText(plugin_->getOllamaUrl());
+    QStringList endpoints = plugin_->getOllamaSystem()->getEndpoints();
+    endpoints.removeOne(plugin_->getOllamaUrl());
+    endpointsText_->setText(endpoints.join(QStringLiteral(", ")));
+    hedgePercentileSpinBox_->setValue(plugin_->getOllamaSystem()->getHedgePercentile());
+    connectTimeoutSpinBox_->setValue(plugin_->getOllamaSystem()->getConnectTimeout() / 1000);
+    firstTokenTimeoutSpinBox_->setValue(plugin_->getOllamaSystem()->getFirstTokenTimeout() / 1000);
+    stallTimeoutSpinBox_->setValue(plugin_->getOllamaSystem()->getStallTimeout() / 1000);
+    inlineCompletionModelComboBox_->setCurrentText(plugin_->getInlineCompletionModel());
+    maxParallelRequestsSpinBox_->setValue(plugin_->getOllamaSystem()->getMaxParallelRequests());
+    seedSpinBox_->setValue(plugin_->getSeed());
+    keepAliveText_->setText(plugin_->getKeepAlive());
+    responseCacheCheckBox_->setChecked(plugin_->getOllamaSystem()->isResponseCacheEnabled());
+    semanticCacheCheckBox_->setChecked(plugin_->getOllamaSystem()->isSemanticCacheEnabled());
+    embeddingModelText_->setText(plugin_->getOllamaSystem()->getEmbeddingModel());
+    semanticCacheThresholdSpinBox_->setValue(plugin_->getOllamaSystem()->getSemanticCacheThreshold());
+}
+
+QStringList KateOllamaConfigPage::getEndpoints() const
+{
+    QStringList endpoints;
+    const QStringList urls = endpointsText_->text().split(QLatin1Char(','), Qt::SkipEmptyParts);
+    for (const QString &url : urls) {
+        QString trimmedUrl = url.trimmed();
+        if (!trimmedUrl.isEmpty() && trimmedUrl != ollamaURLText_->text() && !endpoints.contains(trimmedUrl)) {
+            endpoints.append(trimmedUrl);
+        }
+    }
+    return endpoints;
 }
 
 void KateOllamaConfigPage::loadSettings()
@@ -196,18 +460,48 @@ void KateOllamaConfigPage::loadSettings()
 
     QString model = group.readEntry("Model");
     QString url = group.readEntry("URL");
+    QStringList endpoints = group.readEntry("Endpoints", QStringList());
+    int hedgePercentile = group.readEntry("HedgePercentile", 0);
+    int connectTimeout = group.readEntry("ConnectTimeout", 5);
+    int firstTokenTimeout = group.readEntry("FirstTokenTimeout", 90);
+    int stallTimeout = group.readEntry("StallTimeout", 20);
     QString systemPrompt = group.readEntry("SystemPrompt");
+    QString inlineCompletionModel = group.readEntry("InlineCompletionModel");
+    int maxParallelRequests = group.readEntry("MaxParallelRequests", 1);
+    int seed = group.readEntry("Seed", 0);
+    QString keepAlive = group.readEntry("KeepAlive", "30m");
+    bool responseCache = group.readEntry("ResponseCache", true);
+    bool semanticCache = group.readEntry("SemanticCache", false);
+    QString embeddingModel = group.readEntry("EmbeddingModel", "nomic-embed-text");
+    double semanticCacheThreshold = group.readEntry("SemanticCacheThreshold", 0.92);
 
     if (url.isEmpty()) {
         defaults();
     }
 
     ollamaURLText_->setText(url);
+    endpointsText_->setText(endpoints.join(QStringLiteral(", ")));
+    hedgePercentileSpinBox_->setValue(hedgePercentile);
+    connectTimeoutSpinBox_->setValue(connectTimeout);
+    firstTokenTimeoutSpinBox_->setValue(firstTokenTimeout);
+    stallTimeoutSpinBox_->setValue(stallTimeout);
     systemPromptEdit_->setPlainText(systemPrompt);
+    inlineCompletionModelComboBox_->setCurrentText(inlineCompletionModel);
+    maxParallelRequestsSpinBox_->setValue(maxParallelRequests);
+    seedSpinBox_->setValue(seed);
+    keepAliveText_->setText(keepAlive);
+    responseCacheCheckBox_->setChecked(responseCache);
+    semanticCacheCheckBox_->setChecked(semanticCache);
+    embeddingModelText_->setText(embeddingModel);
+    semanticCacheThresholdSpinBox_->setValue(semanticCacheThreshold);
 
     plugin_->setSystemPrompt(systemPromptEdit_->toPlainText());
     plugin_->setOllamaUrl(ollamaURLText_->text());
     plugin_->setModel(model);
+    plugin_->setInlineCompletionModel(inlineCompletionModel);
+    plugin_->setSeed(seed);
+    plugin_->setKeepAlive(keepAlive);
 
+    plugin_->getOllamaSystem()->preconnect(ollamaURLText_->text());
     fetchModelList();
 }
@@ -9,10 +9,16 @@
 
 #include <KTextEditor/ConfigPage>
 
+#include <QJsonValue>
+#include <QList>
+
 class KateOllamaPlugin;
+class QCheckBox;
 class QLabel;
 class QComboBox;
+class QDoubleSpinBox;
 class QLineEdit;
+class QSpinBox;
 class QTextEdit;
 class QWidget;
 
@@ -36,11 +42,31 @@ public:
     void defaults() override;
     void reset() override;
 
+private slots:
+    void handle_modelsListLoaded(const QString &url, const QList<QJsonValue> &modelsList);
+    void handle_errorFetchingModelsList(const QString &url, const QString &error);
+
 private:
+    // Gets the additional endpoints typed in, without duplicates and without the Ollama URL.
+    QStringList getEndpoints() const;
+
     KateOllamaPlugin *const plugin_;
     QComboBox *modelsComboBox_;
+    QComboBox *inlineCompletionModelComboBox_;
     QTextEdit *systemPromptEdit_;
     QLineEdit *ollamaURLText_;
+    QLineEdit *endpointsText_;
+    QSpinBox *maxParallelRequestsSpinBox_;
+    QSpinBox *hedgePercentileSpinBox_;
+    QSpinBox *connectTimeoutSpinBox_;
+    QSpinBox *firstTokenTimeoutSpinBox_;
+    QSpinBox *stallTimeoutSpinBox_;
+    QSpinBox *seedSpinBox_;
+    QLineEdit *keepAliveText_;
+    QCheckBox *responseCacheCheckBox_;
+    QCheckBox *semanticCacheCheckBox_;
+    QLineEdit *embeddingModelText_;
+    QDoubleSpinBox *semanticCacheThresholdSpinBox_;
     QLabel *infoLabel_;
 };
 
@@ -5,6 +5,8 @@
 #include <QKeyEvent>
 #include <QPlainTextEdit>
 #include <QScrollBar>
+#include <QTextCursor>
+#include <QTimer>
 #include <qevent.h>
 
 class QOllamaPlainTextEdit : public QPlainTextEdit
@@ -14,6 +16,20 @@ public:
     explicit QOllamaPlainTextEdit(QWidget *parent = nullptr)
         : QPlainTextEdit(parent)
     {
+        appendTimer_.setSingleShot(true);
+        appendTimer_.setInterval(AppendIntervalMs);
+        connect(&appendTimer_, &QTimer::timeout, this, &QOllamaPlainTextEdit::flushAppended);
+    }
+
+    // Queues streamed text to be appended at the end of the document.
+    // Text is written in batches, so the cost per second stays bounded however fast tokens arrive.
+    void appendStreamed(const QString &text)
+    {
+        pendingText_.append(text);
+
+        if (!appendTimer_.isActive()) {
+            appendTimer_.start();
+        }
     }
 
 signals:
@@ -33,10 +49,34 @@ protected:
     }
 
 public slots:
-    void onTextChanged()
+    // Appends all queued text. Scrolls along only when the user was already at the bottom,
+    // so reading back in a long chat is not interrupted.
+    void flushAppended()
     {
-        verticalScrollBar()->setValue(verticalScrollBar()->maximum());
+        appendTimer_.stop();
+
+        if (pendingText_.isEmpty()) {
+            return;
+        }
+
+        QScrollBar *scrollBar = verticalScrollBar();
+        bool pinnedToBottom = scrollBar->value() == scrollBar->maximum();
+
+        QTextCursor cursor(document());
+        cursor.movePosition(QTextCursor::End);
+        cursor.insertText(pendingText_);
+        pendingText_.clear();
+
+        if (pinnedToBottom) {
+            scrollBar->setValue(scrollBar->maximum());
+        }
     }
+
+private:
+    static constexpr int AppendIntervalMs = 50;
+
+    QTimer appendTimer_;
+    QString pendingText_;
 };
 
 #endif // QOLLAMAPLAINTEXTEDIT_H
@@ -8,12 +8,28 @@ QSessionButton::QSessionButton(QWidget *parent, QString title)
     , title_(title)
 {
     layout_ = new QHBoxLayout(this);
+    layout_->setContentsMargins(2, 2, 2, 2);
     label_ = new QLabel(QString(title), this);
-    button_ = new QPushButton(QIcon::fromTheme(QStringLiteral("edittrash")), QString(), this);
+    label_->setToolTip(title);
+    label_->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Preferred);
+    button_ = new QPushButton(QIcon::fromTheme(QStringLiteral("edit-delete")), QString(), this);
+    button_->setFlat(true);
+    button_->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
     layout_->addWidget(label_);
     layout_->addWidget(button_);
 
     this->setLayout(layout_);
+    setCursor(Qt::PointingHandCursor);
+
+    connect(button_, &QPushButton::clicked, this, &QSessionButton::handleDeleteButtonClicked);
+}
+
+void QSessionButton::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton) {
+        handleButtonClicked();
+    }
+    QWidget::mousePressEvent(event);
 }
 
 void QSessionButton::handleButtonClicked()
@@ -21,6 +37,18 @@ void QSessionButton::handleButtonClicked()
     emit sessionButtonClicked(uuid_);
 }
 
+void QSessionButton::handleDeleteButtonClicked()
+{
+    emit sessionDeleteClicked(uuid_);
+}
+
+void QSessionButton::setSelected(bool selected)
+{
+    QFont font = label_->font();
+    font.setBold(selected);
+    label_->setFont(font);
+}
+
 void QSessionButton::setUuid(QString uuid)
 {
     uuid_ = uuid;
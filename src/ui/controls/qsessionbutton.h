@@ -2,6 +2,7 @@
 #define QSESSIONBUTTON_H
 
 #include <QLabel>
+#include <QMouseEvent>
 #include <QPushButton>
 #include <QString>
 #include <QVBoxLayout>
@@ -21,11 +22,19 @@ public:
 
     QString generateUniqueId();
 
+    // Sets whether this is the session shown in the tab, which is shown in bold.
+    void setSelected(bool selected);
+
 signals:
     void sessionButtonClicked(const QString &identifier);
+    void sessionDeleteClicked(const QString &identifier);
+
+protected:
+    void mousePressEvent(QMouseEvent *event) override;
 
 private slots:
     void handleButtonClicked();
+    void handleDeleteButtonClicked();
 
 private:
     QString uuid_;
@@ -6,6 +6,8 @@
 // KF Headers
 #include <KActionCollection>
 #include <KLocalizedString>
+#include <KTextEditor/Document>
+#include <KTextEditor/View>
 #include <KXMLGUIClient>
 
 #include <QComboBox>
@@ -20,8 +22,10 @@
 #include <QLocale>
 #include <QObject>
 #include <QPlainTextEdit>
+#include <QSignalBlocker>
 #include <QSizePolicy>
 #include <QSplitter>
+#include <QUrl>
 #include <QVBoxLayout>
 #include <QWidget>
 #include <qnamespace.h>
@@ -30,22 +34,48 @@
 
 #include "src/ollama/ollamadata.h"
 #include "src/ollama/ollamaglobals.h"
+#include "src/ollama/ollamarequest.h"
 #include "src/ollama/ollamaresponse.h"
 #include "src/ollama/ollamasystem.h"
+#include "src/ollama/ollamatokenestimator.h"
 #include "src/ui/controls/qollamaplaintextedit.h"
 #include "src/ui/tabs/maintab.h"
+#include "src/ui/utilities/documentsink.h"
 #include "src/ui/utilities/messages.h"
 #include "src/ui/widgets/toolwidget.h"
 
+// Pause in typing a search after which the session list is searched.
+static constexpr int SessionSearchDelayMs = 200;
+
 MainTab::MainTab(KateOllamaPlugin *plugin, KTextEditor::MainWindow *mainWindow, OllamaSystem *ollamaSystem, OllamaToolWidget *parent)
     : QWidget(parent)
+    , outputInEditor_(false)
     , mainWindow_(mainWindow)
     , plugin_(plugin)
     , ollamaSystem_(ollamaSystem)
 {
-    leftWidget_ = new QWidget(this);
-
-    rightWidget_ = new QWidget(this);
+    leftRightSplitter_ = new QSplitter(Qt::Horizontal, this);
+
+    leftWidget_ = new QWidget(leftRightSplitter_);
+    leftLayout_ = new QVBoxLayout(leftWidget_);
+    leftLayout_->setContentsMargins(0, 0, 0, 0);
+    sessionSearchEdit_ = new QLineEdit(leftWidget_);
+    sessionSearchEdit_->setPlaceholderText(i18n("Search sessions..."));
+    sessionSearchEdit_->setClearButtonEnabled(true);
+    leftLayout_->addWidget(sessionSearchEdit_);
+    sessionScrollArea_ = new QScrollArea(leftWidget_);
+    sessionScrollArea_->setWidgetResizable(true);
+    sessionScrollArea_->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    sessionListWidget_ = new QWidget(sessionScrollArea_);
+    sessionListLayout_ = new QVBoxLayout(sessionListWidget_);
+    sessionListLayout_->setContentsMargins(0, 0, 0, 0);
+    sessionListLayout_->setSpacing(0);
+    sessionListLayout_->addStretch();
+    sessionScrollArea_->setWidget(sessionListWidget_);
+    leftLayout_->addWidget(sessionScrollArea_);
+    leftWidget_->setLayout(leftLayout_);
+
+    rightWidget_ = new QWidget(leftRightSplitter_);
 
     topWidget_ = new QWidget(this);
     topWidget_->setFixedHeight(35);
@@ -57,7 +87,25 @@ MainTab::MainTab(KateOllamaPlugin *plugin, KTextEditor::MainWindow *mainWindow,
     newTabBtn_->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
     newTabBtn_->setFixedHeight(30);
     newTabBtn_->setToolTip(i18n("Add new tab"));
+    stopBtn_ = new QPushButton(QIcon::fromTheme(QStringLiteral("process-stop")), QString(), topWidget_);
+    stopBtn_->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+    stopBtn_->setFixedHeight(30);
+    stopBtn_->setToolTip(i18n("Stop generating"));
+    stopBtn_->setEnabled(false);
+    chatModeBtn_ = new QPushButton(QIcon::fromTheme(QStringLiteral("dialog-messages")), i18n("Chat mode"), topWidget_);
+    chatModeBtn_->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+    chatModeBtn_->setFixedHeight(30);
+    chatModeBtn_->setCheckable(true);
+    chatModeBtn_->setToolTip(i18n("Send the conversation as messages to /api/chat, trimmed to the model's context window"));
+    bypassCacheBtn_ = new QPushButton(QIcon::fromTheme(QStringLiteral("view-refresh")), i18n("Fresh answer"), topWidget_);
+    bypassCacheBtn_->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+    bypassCacheBtn_->setFixedHeight(30);
+    bypassCacheBtn_->setCheckable(true);
+    bypassCacheBtn_->setToolTip(i18n("Generate the answer again instead of replaying a cached one"));
     topLayout_->addWidget(modelsComboBox_);
+    topLayout_->addWidget(chatModeBtn_);
+    topLayout_->addWidget(bypassCacheBtn_);
+    topLayout_->addWidget(stopBtn_);
     topLayout_->addWidget(newTabBtn_);
     topWidget_->setLayout(topLayout_);
 
@@ -89,73 +137,154 @@ MainTab::MainTab(KateOllamaPlugin *plugin, KTextEditor::MainWindow *mainWindow,
     bottomLayout_->addWidget(outputInEditorPushButton_);
     bottomWidget_->setLayout(bottomLayout_);
 
+    rightLayout_ = new QVBoxLayout(rightWidget_);
+    rightLayout_->setContentsMargins(0, 0, 0, 0);
+    rightLayout_->addWidget(topWidget_);
+    rightLayout_->addWidget(middleWidget_);
+    rightLayout_->addWidget(bottomWidget_);
+    rightWidget_->setLayout(rightLayout_);
+
+    leftRightSplitter_->addWidget(leftWidget_);
+    leftRightSplitter_->addWidget(rightWidget_);
+    leftRightSplitter_->setStretchFactor(1, 1);
+    leftRightSplitter_->setSizes({200, 800});
+
     mainLayout_ = new QVBoxLayout(this);
-    mainLayout_->addWidget(topWidget_);
-    mainLayout_->addWidget(middleWidget_);
-    mainLayout_->addWidget(bottomWidget_);
+    mainLayout_->addWidget(leftRightSplitter_);
 
     setLayout(mainLayout_);
 
     connect(newTabBtn_, &QAbstractButton::clicked, parent, &OllamaToolWidget::newTab);
+    connect(stopBtn_, &QAbstractButton::clicked, this, &MainTab::handle_signalStopClicked);
     connect(ollamaSystem_, &OllamaSystem::signal_modelsListLoaded, this, &MainTab::handle_signalModelsListLoaded);
-    connect(ollamaSystem_, &OllamaSystem::signal_ollamaRequestMetaDataChanged, this, &MainTab::handle_signalOllamaRequestMetaDataChanged);
-    connect(ollamaSystem_, &OllamaSystem::signal_ollamaRequestGotResponse, this, &MainTab::handle_signalOllamaRequestGotResponse);
-    connect(ollamaSystem_, &OllamaSystem::signal_ollamaRequestFinished, this, &MainTab::handle_signalOllamaRequestFinished);
+    connect(plugin_->getOllamaSessionStore(), &OllamaSessionStore::signal_sessionsChanged, this, &MainTab::handle_signalSessionsChanged);
+    sessionSearchTimer_.setSingleShot(true);
+    sessionSearchTimer_.setInterval(SessionSearchDelayMs);
+    connect(&sessionSearchTimer_, &QTimer::timeout, this, &MainTab::handle_signalSessionsChanged);
+    connect(sessionSearchEdit_, &QLineEdit::textChanged, &sessionSearchTimer_, qOverload<>(&QTimer::start));
     connect(textAreaInput_, &QOllamaPlainTextEdit::signal_enterKeyWasPressed, this, &MainTab::handle_signal_textAreaInputEnterKeyWasPressed);
-    connect(textAreaOutput_, &QPlainTextEdit::textChanged, textAreaOutput_, &QOllamaPlainTextEdit::onTextChanged);
     connect(outputInEditorPushButton_, &QPushButton::clicked, this, &MainTab::handle_signalOutputInEditorClicked);
+    connect(line_edit_override_ollama_endpoint_, &QLineEdit::editingFinished, this, [this]() {
+        ollamaSystem_->preconnect(getOllamaUrl());
+        loadModels();
+    });
+    // A context only makes sense to the model which produced it.
+    // The new model is loaded right away, while the user types the question.
+    connect(modelsComboBox_, &QComboBox::currentTextChanged, this, [this](const QString &model) {
+        context_.clear();
+
+        OllamaData ollamaData;
+        ollamaData.setOllamaUrl(getOllamaUrl());
+        ollamaData.setModel(model);
+        ollamaData.setKeepAlive(plugin_->getKeepAlive());
+        ollamaSystem_->fetchModelInfo(ollamaData);
+        ollamaSystem_->preloadModel(ollamaData);
+    });
 
     loadModels();
+    handle_signalSessionsChanged();
 }
 
 MainTab::~MainTab()
 {
 }
 
-void MainTab::handle_signalModelsListLoaded(const QList<QJsonValue> &modelsList)
+void MainTab::handle_signalModelsListLoaded(const QString &url, const QList<QJsonValue> &modelsList)
 {
-    int modelSelected = -1;
+    if (url != getOllamaUrl()) {
+        return;
+    }
+
+    // Refilled from scratch, so a revalidated list never duplicates entries.
+    QString selectedModel = modelsComboBox_->currentText();
+    if (selectedModel.isEmpty()) {
+        selectedModel = plugin_->getModel();
+    }
+
+    QSignalBlocker blocker(modelsComboBox_);
+    modelsComboBox_->clear();
+
     for (const QJsonValue &modelValue : modelsList) {
         QJsonObject modelObj = modelValue.toObject();
         if (modelObj.contains("name")) {
             modelsComboBox_->addItem(modelObj["name"].toString());
         }
-
-        if (modelObj["name"].toString() == plugin_->getModel()) {
-            modelSelected = modelsComboBox_->count();
-        }
     }
 
+    int modelSelected = modelsComboBox_->findText(selectedModel);
     if (modelSelected != -1) {
-        modelsComboBox_->setCurrentIndex(modelSelected - 1);
+        modelsComboBox_->setCurrentIndex(modelSelected);
     }
 }
 
 void MainTab::handle_signalOllamaRequestMetaDataChanged(OllamaResponse ollamaResponse)
 {
-    if (ollamaResponse.getReceiver() == "widget" || ollamaResponse.getReceiver() == "" || outputInEditor_) {
-        QTextCursor cursor = textAreaInput_->textCursor();
-        cursor.insertText("\n");
-
-        Messages::showStatusMessage(QStringLiteral("Info: Request started..."), KTextEditor::Message::Information, mainWindow_);
+    if (DocumentSink *sink = editorSinks_.value(ollamaResponse.getRequestId())) {
+        sink->append("\n");
     }
+
+    Messages::showStatusMessage(QStringLiteral("Info: Request started..."), KTextEditor::Message::Information, mainWindow_);
 }
 
 void MainTab::handle_signalOllamaRequestGotResponse(OllamaResponse ollamaResponse)
 {
-    if (ollamaResponse.getReceiver() != "widget" && ollamaResponse.getReceiver() != "")
-        return;
-
-    QTextCursor cursor = textAreaOutput_->textCursor();
-    cursor.insertText(ollamaResponse.getResponseText());
+    auto pendingTurn = pendingTurns_.find(ollamaResponse.getRequestId());
+    if (pendingTurn != pendingTurns_.end() && pendingTurn->firstTokenMs == -1) {
+        pendingTurn->firstTokenMs = pendingTurn->timer.elapsed();
+    }
 
-    Messages::showStatusMessage(QStringLiteral("Info: Reply received..."), KTextEditor::Message::Information, mainWindow_);
+    if (ollamaResponse.getReceiver() == "editor") {
+        if (DocumentSink *sink = editorSinks_.value(ollamaResponse.getRequestId())) {
+            sink->append(ollamaResponse.getResponseText());
+        }
+    } else {
+        textAreaOutput_->appendStreamed(ollamaResponse.getResponseText());
+    }
 }
 
 void MainTab::handle_signalOllamaRequestFinished(OllamaResponse ollamaResponse)
 {
-    if (ollamaResponse.getErrorMessage() != QString("")) {
-        Messages::showStatusMessage(QStringLiteral("Error encountered: ").arg(ollamaResponse.getErrorMessage()),
+    activeRequests_.remove(ollamaResponse.getRequestId());
+    stopBtn_->setEnabled(!activeRequests_.isEmpty());
+
+    if (chatRequests_.remove(ollamaResponse.getRequestId())) {
+        // Keep roles alternating: a question without any answer is dropped, a partial answer is kept.
+        if (ollamaResponse.getResponseText().isEmpty()) {
+            history_.removeLastMessage();
+        } else {
+            history_.addMessage("assistant", ollamaResponse.getResponseText());
+        }
+    } else if (ollamaResponse.getErrorType() == OllamaResponse::NoError && ollamaResponse.isDone()) {
+        context_ = ollamaResponse.getContext();
+    }
+
+    // Whatever was answered is saved, a cancelled answer included.
+    PendingTurn pendingTurn = pendingTurns_.take(ollamaResponse.getRequestId());
+    if (!ollamaResponse.getResponseText().isEmpty()) {
+        OllamaSessionStore *sessionStore = plugin_->getOllamaSessionStore();
+        if (sessionId_.isNull()) {
+            sessionId_ = sessionStore->createSession(pendingTurn.prompt.section(QLatin1Char('\n'), 0, 0).left(80));
+        }
+
+        OllamaSessionStore::Turn turn;
+        turn.prompt = pendingTurn.prompt;
+        turn.response = ollamaResponse.getResponseText();
+        turn.model = pendingTurn.model;
+        turn.started = pendingTurn.started;
+        turn.firstTokenMs = pendingTurn.firstTokenMs;
+        turn.durationMs = pendingTurn.timer.isValid() ? pendingTurn.timer.elapsed() : 0;
+        sessionStore->appendTurn(sessionId_, turn);
+    }
+
+    if (ollamaResponse.getErrorType() == OllamaResponse::CancelledError) {
+        Messages::showStatusMessage(QStringLiteral("Info: Request cancelled..."), KTextEditor::Message::Information, mainWindow_);
+    } else if (ollamaResponse.getSimilarity() > 0) {
+        Messages::showStatusMessage(i18n("Info: Answer of an earlier question which is %1% similar, use Fresh answer to ask the model...",
+                                         qRound(ollamaResponse.getSimilarity() * 100)),
+                                    KTextEditor::Message::Information,
+                                    mainWindow_);
+    } else if (ollamaResponse.getErrorMessage() != QString("")) {
+        Messages::showStatusMessage(QStringLiteral("Error encountered: %1").arg(ollamaResponse.getErrorMessage()),
                                     KTextEditor::Message::Information,
                                     mainWindow_);
         qDebug() << "Error:" << ollamaResponse.getErrorMessage();
@@ -163,9 +292,20 @@ void MainTab::handle_signalOllamaRequestFinished(OllamaResponse ollamaResponse)
         qDebug() << "System prompt:" << plugin_->getSystemPrompt();
     }
 
-    if (ollamaResponse.getReceiver() == "widget" || ollamaResponse.getReceiver() == "") {
-        QTextCursor cursor = textAreaOutput_->textCursor();
-        cursor.insertText("\n\n");
+    if (ollamaResponse.getReceiver() == "editor") {
+        if (DocumentSink *sink = editorSinks_.take(ollamaResponse.getRequestId())) {
+            sink->append("\n");
+            sink->finish();
+            sink->deleteLater();
+        }
+    } else {
+        textAreaOutput_->appendStreamed("\n\n");
+        textAreaOutput_->flushAppended();
+    }
+
+    // The history now ends with an answer again, so the next chat question can be asked.
+    if (chatRequests_.isEmpty() && !queuedChatPrompts_.isEmpty()) {
+        ollamaRequest(queuedChatPrompts_.takeFirst());
     }
 }
 
@@ -193,6 +333,17 @@ void MainTab::handle_signal_textAreaInputEnterKeyWasPressed(QKeyEvent *event)
     }
 }
 
+void MainTab::handle_signalStopClicked()
+{
+    queuedChatPrompts_.clear();
+
+    // Cancelling finishes the request synchronously, which removes it from activeRequests_.
+    const QList<quint64> requestIds = activeRequests_.values();
+    for (quint64 requestId : requestIds) {
+        ollamaSystem_->cancelRequest(requestId);
+    }
+}
+
 void MainTab::handle_signalOutputInEditorClicked()
 {
     if (outputInEditor_ == false) {
@@ -209,15 +360,108 @@ void MainTab::handle_signalOutputInEditorClicked()
     textAreaInput_->setTextCursor(cursor);
 }
 
+void MainTab::handle_signalSessionsChanged()
+{
+    // The latest sessions or the best search hits, older sessions are found by searching.
+    static constexpr int MaxSessionButtons = 100;
+
+    qDeleteAll(sessionButtons_);
+    sessionButtons_.clear();
+
+    OllamaSessionStore *sessionStore = plugin_->getOllamaSessionStore();
+    QList<OllamaSessionStore::Session> sessions;
+    QString query = sessionSearchEdit_->text().trimmed();
+    if (query.isEmpty()) {
+        sessions = sessionStore->getSessions();
+    } else {
+        const QList<OllamaSearchIndex::Hit> hits = plugin_->getOllamaSearchIndex()->search(query, MaxSessionButtons);
+        for (const OllamaSearchIndex::Hit &hit : hits) {
+            sessions.append(sessionStore->getSession(hit.sessionId));
+        }
+    }
+
+    for (const OllamaSessionStore::Session &session : sessions) {
+        if (sessionButtons_.size() == MaxSessionButtons) {
+            break;
+        }
+
+        QSessionButton *sessionButton = new QSessionButton(sessionListWidget_, session.title);
+        sessionButton->setUuid(session.id.toString(QUuid::WithoutBraces));
+        sessionButton->setSelected(session.id == sessionId_);
+        sessionButton->setToolTip(i18np("%2, 1 turn", "%2, %1 turns", session.turnCount, QLocale().toString(session.created, QLocale::ShortFormat)));
+        // Above the stretch which keeps the buttons at the top.
+        sessionListLayout_->insertWidget(sessionListLayout_->count() - 1, sessionButton);
+        sessionButtons_.append(sessionButton);
+
+        connect(sessionButton, &QSessionButton::sessionButtonClicked, this, &MainTab::handle_signalSessionButtonClicked);
+        connect(sessionButton, &QSessionButton::sessionDeleteClicked, this, &MainTab::handle_signalSessionDeleteClicked);
+    }
+}
+
+void MainTab::handle_signalSessionButtonClicked(const QString &identifier)
+{
+    QUuid sessionId = QUuid::fromString(identifier);
+    const QList<OllamaSessionStore::Turn> turns = plugin_->getOllamaSessionStore()->loadTranscript(sessionId);
+
+    // Later questions in this tab continue the session, in chat mode with its history.
+    sessionId_ = sessionId;
+    context_.clear();
+    history_.clear();
+    queuedChatPrompts_.clear();
+
+    textAreaOutput_->flushAppended();
+    textAreaOutput_->clear();
+    for (const OllamaSessionStore::Turn &turn : turns) {
+        textAreaOutput_->appendStreamed(QStringLiteral("> ") + turn.prompt.split(QLatin1Char('\n')).join(QStringLiteral("\n> ")) + QStringLiteral("\n\n"));
+        textAreaOutput_->appendStreamed(turn.response + QStringLiteral("\n\n"));
+        history_.addMessage("user", turn.prompt);
+        history_.addMessage("assistant", turn.response);
+    }
+    textAreaOutput_->flushAppended();
+
+    for (QSessionButton *sessionButton : std::as_const(sessionButtons_)) {
+        sessionButton->setSelected(sessionButton->getUuid() == identifier);
+    }
+}
+
+void MainTab::handle_signalSessionDeleteClicked(const QString &identifier)
+{
+    QUuid sessionId = QUuid::fromString(identifier);
+    if (sessionId == sessionId_) {
+        sessionId_ = QUuid();
+    }
+
+    // Rebuilds the list, which deletes the button that was clicked, so it is done once its signal returned.
+    QMetaObject::invokeMethod(
+        this,
+        [this, sessionId]() {
+            plugin_->getOllamaSessionStore()->removeSession(sessionId);
+        },
+        Qt::QueuedConnection);
+}
+
 void MainTab::loadModels()
 {
     OllamaData ollamaData;
 
-    ollamaData.setOllamaUrl(plugin_->getOllamaUrl());
+    ollamaData.setOllamaUrl(getOllamaUrl());
 
+    // Show what the registry already knows, fetchModels only goes to the server when that is missing or stale.
+    handle_signalModelsListLoaded(ollamaData.getOllamaUrl(), ollamaSystem_->getModels(ollamaData.getOllamaUrl()));
     ollamaSystem_->fetchModels(ollamaData);
 }
 
+QString MainTab::getOllamaUrl()
+{
+    QString ollamaUrl = line_edit_override_ollama_endpoint_->text().trimmed();
+
+    if (!ollamaUrl.isEmpty() && QUrl(ollamaUrl).isValid()) {
+        return ollamaUrl;
+    }
+
+    return plugin_->getOllamaUrl();
+}
+
 QString MainTab::getPrompt()
 {
     Messages::showStatusMessage(QStringLiteral("Info: Getting prompt..."), KTextEditor::Message::Information, mainWindow_);
@@ -233,19 +477,25 @@ void MainTab::ollamaRequest(QString prompt)
 
     QVector<QString> images;
 
+    // The history holds one open question at most, so its answer is always added after the right question.
+    if (chatModeBtn_->isChecked() && !chatRequests_.isEmpty()) {
+        queuedChatPrompts_.append(prompt);
+        Messages::showStatusMessage(QStringLiteral("Info: Question queued until the current answer is finished..."),
+                                    KTextEditor::Message::Information,
+                                    mainWindow_);
+        return;
+    }
+
+    data.setPriority(OllamaData::ChatPriority);
+    data.setCacheBypassed(bypassCacheBtn_->isChecked());
     if (outputInEditor_) {
         data.setSender("editor");
     } else {
         data.setSender("widget");
     }
 
-    QString ollamaUrl = line_edit_override_ollama_endpoint_->displayText();
-
-    if (ollamaUrl != nullptr && ollamaUrl != "" && data.isOllamaUrlValid()) {
-        data.setOllamaUrl(ollamaUrl);
-    } else {
-        data.setOllamaUrl(plugin_->getOllamaUrl());
-    }
+    data.setOllamaUrl(getOllamaUrl());
+    data.setKeepAlive(plugin_->getKeepAlive());
 
     QString model = modelsComboBox_->currentText();
 
@@ -255,19 +505,58 @@ void MainTab::ollamaRequest(QString prompt)
         data.setModel(plugin_->getModel());
     }
 
-    data.setPrompt(prompt);
-    data.setSuffix("");
+    // Known after the first question at the latest, until then a conservative default is used.
+    ollamaSystem_->fetchModelInfo(data);
+
+    if (chatModeBtn_->isChecked()) {
+        history_.addMessage("user", prompt);
+
+        // Leave a quarter of the context window for the answer.
+        int contextLength = ollamaSystem_->getContextLength(data.getOllamaUrl(), data.getModel());
+        int systemPromptTokens = OllamaTokenEstimator::estimateTokens(plugin_->getSystemPrompt());
+        history_.trim(contextLength * 3 / 4 - systemPromptTokens);
+
+        data.setMessages(history_.toJson(plugin_->getSystemPrompt()));
+    } else {
+        data.setPrompt(prompt);
+        data.setSuffix("");
+        data.setSystemPrompt(plugin_->getSystemPrompt());
+        // Continue the conversation of this tab, Ollama then skips evaluating the earlier turns again.
+        data.setContext(context_);
+        // The first question of a conversation stands on its own, so a similar earlier one has the same answer.
+        data.setSemanticCacheAllowed(context_.isEmpty());
+    }
 
     for (int i = 0; i < images.size(); ++i) {
         data.addImage(images[i]);
     }
 
     // data.setFormat("");
-    // data.setOptions("");
-    data.setSystemPrompt(plugin_->getSystemPrompt());
-    // data.setContext("");
+    // A fixed seed makes answers reproducible, which lets OllamaSystem cache them.
+    if (plugin_->getSeed() != 0) {
+        data.setOptions(QJsonObject{{"seed", plugin_->getSeed()}});
+    }
     // data.setStream("");
 
     // we need to connect to the response as that is asynchronous.
-    ollamaSystem_->ollamaRequest(data);
+    OllamaRequest *request = ollamaSystem_->ollamaRequest(data);
+    activeRequests_.insert(request->getId());
+
+    PendingTurn &pendingTurn = pendingTurns_[request->getId()];
+    pendingTurn.prompt = prompt;
+    pendingTurn.model = data.getModel();
+    pendingTurn.started = QDateTime::currentDateTime();
+    pendingTurn.timer.start();
+    if (data.isChat()) {
+        chatRequests_.insert(request->getId());
+    }
+    stopBtn_->setEnabled(true);
+    if (outputInEditor_) {
+        if (KTextEditor::View *view = mainWindow_->activeView()) {
+            editorSinks_.insert(request->getId(), new DocumentSink(view->document(), view->cursorPosition(), this));
+        }
+    }
+    connect(request, &OllamaRequest::signal_metaDataChanged, this, &MainTab::handle_signalOllamaRequestMetaDataChanged);
+    connect(request, &OllamaRequest::signal_gotResponse, this, &MainTab::handle_signalOllamaRequestGotResponse);
+    connect(request, &OllamaRequest::signal_finished, this, &MainTab::handle_signalOllamaRequestFinished);
 }
@@ -13,25 +13,37 @@
 #include <KXMLGUIClient>
 
 #include <QComboBox>
+#include <QDateTime>
+#include <QElapsedTimer>
 #include <QHBoxLayout>
+#include <QHash>
 #include <QLabel>
 #include <QLineEdit>
 #include <QObject>
 #include <QPlainTextEdit>
 #include <QPushButton>
+#include <QScrollArea>
+#include <QSet>
 #include <QSpacerItem>
 #include <QSplitter>
+#include <QStringList>
+#include <QTimer>
+#include <QUuid>
 #include <QVBoxLayout>
 #include <QWidget>
 #include <qevent.h>
 #include <qlist.h>
 
+#include "src/ollama/ollamachathistory.h"
 #include "src/ollama/ollamaresponse.h"
 #include "src/ollama/ollamasystem.h"
 #include "src/plugin.h"
 #include "src/ui/controls//qollamaplaintextedit.h"
+#include "src/ui/controls/qsessionbutton.h"
 #include "src/ui/widgets/toolwidget.h"
 
+class DocumentSink;
+
 class MainTab : public QWidget, public KXMLGUIClient
 {
     Q_OBJECT
@@ -41,7 +53,7 @@ public:
     ~MainTab();
 
 public slots:
-    void handle_signalModelsListLoaded(const QList<QJsonValue> &modelsList);
+    void handle_signalModelsListLoaded(const QString &url, const QList<QJsonValue> &modelsList);
     // void handle_signalOnSinglePrompt();
     // void handle_signalOnFullPrompt();
 
@@ -51,9 +63,16 @@ public slots:
 
     void handle_signal_textAreaInputEnterKeyWasPressed(QKeyEvent *event);
     void handle_signalOutputInEditorClicked();
+    void handle_signalStopClicked();
+
+    void handle_signalSessionsChanged();
+    void handle_signalSessionButtonClicked(const QString &identifier);
+    void handle_signalSessionDeleteClicked(const QString &identifier);
 
 private:
     void loadModels();
+    // Gets the endpoint of this tab: the override when one is filled in, else the configured one.
+    QString getOllamaUrl();
     QString getPrompt();
     void ollamaRequest(QString prompt);
 
@@ -65,9 +84,14 @@ private:
 
     QWidget *leftWidget_;
     QVBoxLayout *leftLayout_;
+    QLineEdit *sessionSearchEdit_;
+    // Searches once typing in the search box pauses, instead of on every key.
+    QTimer sessionSearchTimer_;
+    QScrollArea *sessionScrollArea_;
+    QWidget *sessionListWidget_;
+    QVBoxLayout *sessionListLayout_;
 
-    QList<QPushButton> *sessionButtons_; // These buttons need to be added based on the saved sessions.
-    // Need a custom control with a label and a button for deletion.
+    QList<QSessionButton *> sessionButtons_; // One per saved session, newest first.
 
     QWidget *rightWidget_;
     QVBoxLayout *rightLayout_; // this houses the main interface. We need to add the top, middle, bottom widget to it.
@@ -78,6 +102,9 @@ private:
     QHBoxLayout *topLayout_;
     QComboBox *modelsComboBox_;
     QPushButton *newTabBtn_;
+    QPushButton *stopBtn_;
+    QPushButton *chatModeBtn_;
+    QPushButton *bypassCacheBtn_;
 
     QWidget *middleWidget_;
     QHBoxLayout *middleLayout_;
@@ -93,5 +120,30 @@ private:
 
     KateOllamaPlugin *plugin_;
     OllamaSystem *ollamaSystem_;
+
+    // Conversation state returned by the last answer, sent with the next question.
+    QList<qint64> context_;
+    // Conversation sent with every question in chat mode.
+    OllamaChatHistory history_;
+    // Running requests which were sent in chat mode.
+    QSet<quint64> chatRequests_;
+    // Chat questions asked while another one is answered, sent in order once it finished.
+    QStringList queuedChatPrompts_;
+    // Requests of this tab which are still running.
+    QSet<quint64> activeRequests_;
+    // Where the response is written when "Output in editor" is on, by request id.
+    QHash<quint64, DocumentSink *> editorSinks_;
+
+    // A question of this tab which is being answered, saved as a turn of the session once it finished.
+    struct PendingTurn {
+        QString prompt;
+        QString model;
+        QDateTime started;
+        QElapsedTimer timer;
+        qint64 firstTokenMs = -1;
+    };
+    QHash<quint64, PendingTurn> pendingTurns_;
+    // The session the turns of this tab are saved in, created with the first answer.
+    QUuid sessionId_;
 };
 #endif // MAINTAB_H
@@ -0,0 +1,139 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include <QList>
+#include <QStringList>
+
+#include "src/ollama/ollamatokenestimator.h"
+#include "src/ui/utilities/contextbuilder.h"
+
+// Part of the budget the header may use at most.
+static const int HeaderBudgetDivisor = 5;
+
+QString ContextBuilder::build(KTextEditor::Document *document, int markerLine, int cursorLine, int tokenBudget)
+{
+    const int lineCount = document->lines();
+    tokenBudget = qMax(0, tokenBudget);
+    const int firstLine = qBound(0, qMin(markerLine, cursorLine), lineCount - 1);
+    const int lastLine = qBound(0, qMax(markerLine, cursorLine), lineCount - 1);
+
+    // The header: leading lines up to the first line of actual code.
+    int headerEnd = 0;
+    int headerTokens = 0;
+    while (headerEnd < lineCount && headerEnd < firstLine) {
+        QString line = document->line(headerEnd);
+        int tokens = OllamaTokenEstimator::estimateTokens(line) + 1;
+        if (!isHeaderLine(line) || headerTokens + tokens > tokenBudget / HeaderBudgetDivisor) {
+            break;
+        }
+        headerTokens += tokens;
+        ++headerEnd;
+    }
+
+    int budget = tokenBudget - headerTokens;
+
+    // One window from the first to the last line when it fits, otherwise one around each.
+    // The lines themselves are always sent, even when they alone are over budget.
+    int windowTokens = 0;
+    for (int line = firstLine; line <= lastLine && (line == firstLine || windowTokens <= budget); ++line) {
+        windowTokens += OllamaTokenEstimator::estimateTokens(document->line(line)) + 1;
+    }
+
+    QList<Window> windows;
+    if (firstLine == lastLine || windowTokens <= budget) {
+        windows.append(Window{firstLine, lastLine + 1});
+    } else {
+        windows.append(Window{firstLine, firstLine + 1});
+        windows.append(Window{lastLine, lastLine + 1});
+        windowTokens = OllamaTokenEstimator::estimateTokens(document->line(firstLine)) + 1
+            + OllamaTokenEstimator::estimateTokens(document->line(lastLine)) + 1;
+    }
+
+    // The windows grow in turns, each two lines up for every line down, until they reach their neighbours.
+    bool grown = true;
+    while (grown) {
+        grown = false;
+        for (qsizetype i = 0; i < windows.size(); ++i) {
+            Window &window = windows[i];
+            int minLine = i == 0 ? headerEnd : windows.at(i - 1).end;
+            int maxLine = i == windows.size() - 1 ? lineCount : windows.at(i + 1).start;
+            if (!window.growing || (window.start <= minLine && window.end >= maxLine)) {
+                window.growing = false;
+                continue;
+            }
+
+            bool up = (window.step++ % 3 != 2 && window.start > minLine) || window.end >= maxLine;
+            int line = up ? window.start - 1 : window.end;
+
+            int tokens = OllamaTokenEstimator::estimateTokens(document->line(line)) + 1;
+            if (windowTokens + tokens > budget) {
+                window.growing = false;
+                continue;
+            }
+            windowTokens += tokens;
+            grown = true;
+
+            if (up) {
+                --window.start;
+            } else {
+                ++window.end;
+            }
+        }
+    }
+
+    QStringList lines;
+    lines.reserve(headerEnd + windows.last().end - windows.first().start + 3);
+
+    for (int line = 0; line < headerEnd; ++line) {
+        lines.append(document->line(line));
+    }
+    int previousEnd = headerEnd;
+    for (const Window &window : std::as_const(windows)) {
+        if (window.start > previousEnd) {
+            lines.append(QStringLiteral("..."));
+        }
+        for (int line = window.start; line < window.end; ++line) {
+            lines.append(document->line(line));
+        }
+        previousEnd = window.end;
+    }
+    if (previousEnd < lineCount) {
+        lines.append(QStringLiteral("..."));
+    }
+
+    return lines.join(QLatin1Char('\n'));
+}
+
+bool ContextBuilder::isHeaderLine(const QString &line)
+{
+    static const QStringList headerPrefixes = {
+        QStringLiteral("#"), // C and C++ preprocessor, shell and Python comments
+        QStringLiteral("//"),
+        QStringLiteral("/*"),
+        QStringLiteral("*"),
+        QStringLiteral("--"),
+        QStringLiteral("import "),
+        QStringLiteral("from "),
+        QStringLiteral("using "),
+        QStringLiteral("package "),
+        QStringLiteral("require"),
+        QStringLiteral("use "),
+        QStringLiteral("<?php"),
+    };
+
+    QString trimmed = line.trimmed();
+    if (trimmed.isEmpty()) {
+        return true;
+    }
+
+    for (const QString &prefix : headerPrefixes) {
+        if (trimmed.startsWith(prefix)) {
+            return true;
+        }
+    }
+
+    return false;
+}
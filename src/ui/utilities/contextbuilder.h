@@ -0,0 +1,41 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+#ifndef CONTEXTBUILDER_H
+#define CONTEXTBUILDER_H
+
+#include <KTextEditor/Document>
+
+#include <QString>
+
+/*
+ * Picks the part of a document which is sent along with a prompt.
+ * Large files do not fit in the model's context window and take long to evaluate, so only the file header
+ * (imports, includes) and windows of lines around the places the prompt is about are sent.
+ */
+class ContextBuilder
+{
+public:
+    // Builds text from the document which fits in tokenBudget estimated tokens.
+    // The window covers markerLine, cursorLine and the lines between them, or when those do not fit, there is a window
+    // around each. Windows reach twice as far up as down, code above the prompt tends to matter more.
+    static QString build(KTextEditor::Document *document, int markerLine, int cursorLine, int tokenBudget);
+
+private:
+    // Lines [start, end) of the document.
+    struct Window {
+        int start = 0;
+        int end = 0;
+        // Counts the lines added, to pick the direction of the next one.
+        int step = 0;
+        // False once the window reached its neighbours or its next line did not fit in the budget.
+        bool growing = true;
+    };
+
+    // Whether the line belongs to the header of a file: includes, imports, comments and the like.
+    static bool isHeaderLine(const QString &line);
+};
+
+#endif // CONTEXTBUILDER_H
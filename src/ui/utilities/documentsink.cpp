@@ -0,0 +1,90 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include "src/ui/utilities/documentsink.h"
+
+// Roughly one display frame.
+static const int FlushIntervalMs = 16;
+
+int DocumentSink::writing_ = 0;
+
+DocumentSink::DocumentSink(KTextEditor::Document *document, const KTextEditor::Cursor &position, QObject *parent)
+    : QObject(parent)
+    , document_(document)
+    , position_(document->newMovingCursor(position, KTextEditor::MovingCursor::MoveOnInsert))
+{
+    flushTimer_.setSingleShot(true);
+    flushTimer_.setInterval(FlushIntervalMs);
+    connect(&flushTimer_, &QTimer::timeout, this, &DocumentSink::flush);
+
+    // Moving cursors must be gone before the document destroys its buffer.
+    connect(document, &KTextEditor::Document::aboutToDeleteMovingInterfaceContent, this, [this]() {
+        pending_.clear();
+        position_.reset();
+        transaction_.reset();
+    });
+}
+
+DocumentSink::~DocumentSink()
+{
+    finish();
+}
+
+void DocumentSink::append(const QString &text)
+{
+    if (text.isEmpty()) {
+        return;
+    }
+
+    pending_.append(text);
+
+    if (!flushTimer_.isActive()) {
+        flushTimer_.start();
+    }
+}
+
+void DocumentSink::flush()
+{
+    flushTimer_.stop();
+
+    if (pending_.isEmpty() || !document_ || !position_) {
+        pending_.clear();
+        return;
+    }
+
+    if (!transaction_) {
+        transaction_ = std::make_unique<KTextEditor::Document::EditingTransaction>(document_);
+    }
+    ++writing_;
+    document_->insertText(position_->toCursor(), pending_);
+    --writing_;
+    pending_.clear();
+}
+
+void DocumentSink::finish()
+{
+    flush();
+
+    // The document reports the change when the transaction ends.
+    ++writing_;
+    transaction_.reset();
+    --writing_;
+}
+
+KTextEditor::Document *DocumentSink::getDocument() const
+{
+    return document_;
+}
+
+KTextEditor::Cursor DocumentSink::getPosition() const
+{
+    return position_ ? position_->toCursor() : KTextEditor::Cursor::invalid();
+}
+
+bool DocumentSink::isWriting()
+{
+    return writing_ > 0;
+}
@@ -0,0 +1,60 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+#ifndef DOCUMENTSINK_H
+#define DOCUMENTSINK_H
+
+#include <KTextEditor/Cursor>
+#include <KTextEditor/Document>
+#include <KTextEditor/MovingCursor>
+
+#include <QObject>
+#include <QPointer>
+#include <QString>
+#include <QTimer>
+
+#include <memory>
+
+/*
+ * Writes streamed text into a document at a fixed position.
+ * Tokens are buffered and written at most once per frame, so highlighting and layout run once per frame
+ * instead of once per token. The position moves along with edits made elsewhere in the document.
+ * All writes of a sink share one editing transaction, from the first flush until finish, so the whole response is
+ * undone in one step.
+ */
+class DocumentSink : public QObject
+{
+    Q_OBJECT
+
+public:
+    DocumentSink(KTextEditor::Document *document, const KTextEditor::Cursor &position, QObject *parent = nullptr);
+    ~DocumentSink();
+
+    // Queues text, it is written to the document on the next flush.
+    void append(const QString &text);
+    // Writes all queued text to the document immediately.
+    void flush();
+    // Writes all queued text and ends the editing transaction, the response is complete.
+    void finish();
+
+    // Gets the document the text is written to, or nullptr when it was closed.
+    KTextEditor::Document *getDocument() const;
+    // Gets the position after the last written text.
+    KTextEditor::Cursor getPosition() const;
+    // Whether a sink is writing to a document right now, so textChanged handlers can tell its edits from the user's.
+    static bool isWriting();
+
+private:
+    QPointer<KTextEditor::Document> document_;
+    std::unique_ptr<KTextEditor::MovingCursor> position_;
+    // Open from the first flush until finish.
+    std::unique_ptr<KTextEditor::Document::EditingTransaction> transaction_;
+    QString pending_;
+    QTimer flushTimer_;
+    // Sinks writing right now, the text of a document only changes on the UI thread.
+    static int writing_;
+};
+
+#endif // DOCUMENTSINK_H
@@ -0,0 +1,142 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include <QStringMatcher>
+
+#include <algorithm>
+
+#include "src/ui/utilities/markerindex.h"
+
+static const QString Marker = QStringLiteral("// AI:");
+
+MarkerIndex *MarkerIndex::forDocument(KTextEditor::Document *document)
+{
+    MarkerIndex *index = document->findChild<MarkerIndex *>(QString(), Qt::FindDirectChildrenOnly);
+    if (!index) {
+        index = new MarkerIndex(document);
+    }
+
+    return index;
+}
+
+MarkerIndex::MarkerIndex(KTextEditor::Document *document)
+    : QObject(document)
+    , document_(document)
+{
+    // The edits during a reload are not reliable to follow, the index is built again when needed.
+    connect(document, &KTextEditor::Document::aboutToReload, this, [this]() {
+        valid_ = false;
+    });
+}
+
+int MarkerIndex::findNearestMarker(int line)
+{
+    if (!valid_) {
+        rebuild();
+    }
+
+    if (markerLines_.isEmpty()) {
+        return -1;
+    }
+
+    auto it = std::upper_bound(markerLines_.cbegin(), markerLines_.cend(), line);
+    if (it != markerLines_.cbegin()) {
+        return *(it - 1);
+    }
+
+    return *it;
+}
+
+QString MarkerIndex::getPrompt(int line) const
+{
+    QString text = document_->line(line);
+
+    qsizetype position = findMarker(text);
+    if (position == -1) {
+        return QString();
+    }
+
+    return QStringView(text).sliced(position).trimmed().toString();
+}
+
+qsizetype MarkerIndex::findMarker(QStringView text)
+{
+    static const QStringMatcher matcher(Marker);
+
+    qsizetype position = matcher.indexIn(text);
+    if (position == -1) {
+        return -1;
+    }
+
+    return position + Marker.size();
+}
+
+void MarkerIndex::handle_textInserted(KTextEditor::Document *document, const KTextEditor::Range &range)
+{
+    Q_UNUSED(document);
+
+    // The text which was on the first line may now be on the last line of the range.
+    shiftLines(range.start().line(), range.end().line() - range.start().line());
+    rescanLines(range.start().line(), range.end().line());
+}
+
+void MarkerIndex::handle_textRemoved(KTextEditor::Document *document, const KTextEditor::Range &range, const QString &oldText)
+{
+    Q_UNUSED(document);
+    Q_UNUSED(oldText);
+
+    // What remains of the removed lines is joined on the first line.
+    auto first = std::lower_bound(markerLines_.begin(), markerLines_.end(), range.start().line());
+    auto last = std::upper_bound(first, markerLines_.end(), range.end().line());
+    markerLines_.erase(first, last);
+
+    shiftLines(range.end().line(), range.start().line() - range.end().line());
+    rescanLines(range.start().line(), range.start().line());
+}
+
+void MarkerIndex::rebuild()
+{
+    markerLines_.clear();
+
+    const int lineCount = document_->lines();
+    for (int line = 0; line < lineCount; ++line) {
+        if (findMarker(document_->line(line)) != -1) {
+            markerLines_.append(line);
+        }
+    }
+
+    if (!valid_) {
+        // Follow the edits from now on, until the next reload.
+        connect(document_, &KTextEditor::Document::textInsertedRange, this, &MarkerIndex::handle_textInserted, Qt::UniqueConnection);
+        connect(document_, &KTextEditor::Document::textRemoved, this, &MarkerIndex::handle_textRemoved, Qt::UniqueConnection);
+    }
+    valid_ = true;
+}
+
+void MarkerIndex::rescanLines(int firstLine, int lastLine)
+{
+    auto first = std::lower_bound(markerLines_.begin(), markerLines_.end(), firstLine);
+    auto last = std::upper_bound(first, markerLines_.end(), lastLine);
+    qsizetype insertAt = markerLines_.erase(first, last) - markerLines_.begin();
+
+    lastLine = qMin(lastLine, document_->lines() - 1);
+    for (int line = firstLine; line <= lastLine; ++line) {
+        if (findMarker(document_->line(line)) != -1) {
+            markerLines_.insert(insertAt++, line);
+        }
+    }
+}
+
+void MarkerIndex::shiftLines(int afterLine, int delta)
+{
+    if (delta == 0) {
+        return;
+    }
+
+    for (auto it = std::upper_bound(markerLines_.begin(), markerLines_.end(), afterLine); it != markerLines_.end(); ++it) {
+        *it += delta;
+    }
+}
@@ -0,0 +1,59 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+#ifndef MARKERINDEX_H
+#define MARKERINDEX_H
+
+#include <KTextEditor/Document>
+#include <KTextEditor/Range>
+
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringView>
+
+/*
+ * Keeps the lines of a document which hold a "// AI:" prompt marker.
+ * The index is built line by line on first use and then updated from the edits of the document,
+ * so finding the prompt near the cursor does not copy or search the whole document.
+ */
+class MarkerIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Gets the index of the document, it is created on first use and lives as long as the document.
+    static MarkerIndex *forDocument(KTextEditor::Document *document);
+
+    // Gets the line of the marker nearest to the given line: the closest on or above it, else the closest below it.
+    // Returns -1 when the document has no marker.
+    int findNearestMarker(int line);
+    // Gets the prompt of the marker on the given line, or an empty string when there is none.
+    QString getPrompt(int line) const;
+
+    // Gets the position right after the marker in the text, or -1 when the text holds no marker.
+    static qsizetype findMarker(QStringView text);
+
+private slots:
+    void handle_textInserted(KTextEditor::Document *document, const KTextEditor::Range &range);
+    void handle_textRemoved(KTextEditor::Document *document, const KTextEditor::Range &range, const QString &oldText);
+
+private:
+    explicit MarkerIndex(KTextEditor::Document *document);
+
+    void rebuild();
+    // Removes the markers from firstLine up to and including lastLine, then looks for markers in those lines again.
+    void rescanLines(int firstLine, int lastLine);
+    // Moves the markers below afterLine by delta lines.
+    void shiftLines(int afterLine, int delta);
+
+    KTextEditor::Document *document_;
+    // Sorted line numbers.
+    QList<int> markerLines_;
+    // Whether markerLines_ matches the document. It is rebuilt lazily after a reload.
+    bool valid_ = false;
+};
+
+#endif // MARKERINDEX_H
@@ -0,0 +1,284 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+
+#include <KTextEditor/Range>
+
+#include <QFontMetrics>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QKeyEvent>
+#include <QPainter>
+
+#include "src/ollama/ollamadata.h"
+#include "src/ollama/ollamarequest.h"
+#include "src/ollama/ollamaspeculator.h"
+#include "src/ollama/ollamasystem.h"
+#include "src/plugin.h"
+#include "src/ui/views/inlinecompletion.h"
+
+using namespace Qt::Literals::StringLiterals;
+
+// Typing pause after which a completion is requested.
+static constexpr int DebounceMs = 300;
+// A completion which has not started streaming by then is no longer worth waiting for.
+static constexpr int FirstTokenBudgetMs = 1500;
+// Lines around the cursor sent as prompt and suffix.
+static constexpr int PrefixLines = 60;
+static constexpr int SuffixLines = 20;
+static constexpr int MaxPredictTokens = 64;
+
+InlineCompletion *InlineCompletion::forView(KTextEditor::View *view, KateOllamaPlugin *plugin, OllamaSystem *ollamaSystem)
+{
+    InlineCompletion *inlineCompletion = view->findChild<InlineCompletion *>(QString(), Qt::FindDirectChildrenOnly);
+    if (!inlineCompletion) {
+        inlineCompletion = new InlineCompletion(view, plugin, ollamaSystem);
+    }
+    return inlineCompletion;
+}
+
+InlineCompletion::InlineCompletion(KTextEditor::View *view, KateOllamaPlugin *plugin, OllamaSystem *ollamaSystem)
+    : view_(view)
+    , plugin_(plugin)
+    , ollamaSystem_(ollamaSystem)
+{
+    setParent(view);
+
+    debounceTimer_.setSingleShot(true);
+    debounceTimer_.setInterval(DebounceMs);
+    connect(&debounceTimer_, &QTimer::timeout, this, &InlineCompletion::handle_debounceTimeout);
+
+    latencyTimer_.setSingleShot(true);
+    latencyTimer_.setInterval(FirstTokenBudgetMs);
+    connect(&latencyTimer_, &QTimer::timeout, this, &InlineCompletion::dismiss);
+
+    connect(view_->document(), &KTextEditor::Document::textChanged, this, &InlineCompletion::handle_textChanged);
+    connect(view_, &KTextEditor::View::cursorPositionChanged, this, &InlineCompletion::handle_cursorPositionChanged);
+
+    view_->registerInlineNoteProvider(this);
+    // Tab and Escape reach the editor widget before any action, so they are filtered there.
+    QWidget *editorWidget = view_->focusProxy() ? view_->focusProxy() : view_.data();
+    editorWidget->installEventFilter(this);
+}
+
+InlineCompletion::~InlineCompletion()
+{
+    cancelRequest();
+    if (view_) {
+        view_->unregisterInlineNoteProvider(this);
+    }
+}
+
+QList<int> InlineCompletion::inlineNotes(int line) const
+{
+    if (suggestion_.isEmpty() || line != position_.line()) {
+        return {};
+    }
+    return {position_.column()};
+}
+
+QSize InlineCompletion::inlineNoteSize(const KTextEditor::InlineNote &note) const
+{
+    QFontMetrics fontMetrics(note.font());
+    return QSize(fontMetrics.horizontalAdvance(suggestion_.split(u'\n').join(u" ⏎ "_s)), note.lineHeight());
+}
+
+void InlineCompletion::paintInlineNote(const KTextEditor::InlineNote &note, QPainter &painter, Qt::LayoutDirection direction) const
+{
+    Q_UNUSED(direction);
+
+    // Newlines are shown as a marker, the note has to fit on the line it is on.
+    QColor color = note.view()->palette().color(QPalette::Text);
+    color.setAlphaF(0.45);
+    painter.setFont(note.font());
+    painter.setPen(color);
+    painter.drawText(QRect(QPoint(0, 0), inlineNoteSize(note)), Qt::AlignLeft | Qt::AlignVCenter, suggestion_.split(u'\n').join(u" ⏎ "_s));
+}
+
+void InlineCompletion::accept()
+{
+    if (suggestion_.isEmpty()) {
+        return;
+    }
+
+    QString suggestion = suggestion_;
+    KTextEditor::Cursor position = position_;
+    cancelRequest();
+    setSuggestion(QString());
+
+    accepting_ = true;
+    view_->document()->insertText(position, suggestion);
+    accepting_ = false;
+}
+
+void InlineCompletion::dismiss()
+{
+    debounceTimer_.stop();
+    cancelRequest();
+    setSuggestion(QString());
+}
+
+bool InlineCompletion::eventFilter(QObject *watched, QEvent *event)
+{
+    if (event->type() == QEvent::ShortcutOverride || event->type() == QEvent::KeyPress) {
+        auto *keyEvent = static_cast<QKeyEvent *>(event);
+        if (keyEvent->modifiers() == Qt::NoModifier && !suggestion_.isEmpty()) {
+            if (keyEvent->key() == Qt::Key_Tab) {
+                // Claiming the override keeps Tab from indenting or moving focus.
+                event->accept();
+                if (event->type() == QEvent::KeyPress) {
+                    accept();
+                }
+                return true;
+            }
+            if (keyEvent->key() == Qt::Key_Escape && event->type() == QEvent::KeyPress) {
+                dismiss();
+            }
+        }
+    }
+    return KTextEditor::InlineNoteProvider::eventFilter(watched, event);
+}
+
+void InlineCompletion::handle_textChanged(KTextEditor::Document *document)
+{
+    Q_UNUSED(document);
+
+    if (accepting_) {
+        return;
+    }
+
+    // Whatever is running or shown belongs to text which no longer exists.
+    dismiss();
+    if (plugin_->isInlineCompletionEnabled() && view_->hasFocus()) {
+        debounceTimer_.start();
+    }
+}
+
+void InlineCompletion::handle_cursorPositionChanged(KTextEditor::View *view, const KTextEditor::Cursor &newPosition)
+{
+    Q_UNUSED(view);
+
+    if (!accepting_ && position_.isValid() && newPosition != position_) {
+        dismiss();
+    }
+}
+
+void InlineCompletion::handle_debounceTimeout()
+{
+    KTextEditor::Document *document = view_->document();
+    KTextEditor::Cursor cursor = view_->cursorPosition();
+
+    // Only complete at the end of a line, text after the cursor would be painted over.
+    if (!document->text(KTextEditor::Range(cursor, KTextEditor::Cursor(cursor.line(), document->lineLength(cursor.line())))).trimmed().isEmpty()) {
+        return;
+    }
+
+    int lastLine = qMin(document->lines() - 1, cursor.line() + SuffixLines);
+    QString prefix = document->text(KTextEditor::Range(KTextEditor::Cursor(qMax(0, cursor.line() - PrefixLines), 0), cursor));
+    QString suffix = document->text(KTextEditor::Range(cursor, KTextEditor::Cursor(lastLine, document->lineLength(lastLine))));
+    if (prefix.trimmed().isEmpty()) {
+        return;
+    }
+
+    QString model = plugin_->getInlineCompletionModel();
+    if (model.isEmpty()) {
+        model = plugin_->getModel();
+    }
+
+    // A short deterministic answer which ends at the first blank line.
+    QJsonObject options;
+    options.insert("num_predict", MaxPredictTokens);
+    options.insert("temperature", 0);
+    options.insert("stop", QJsonArray({"\n\n"}));
+
+    OllamaData data;
+    data.setSender("inline");
+    data.setPriority(OllamaData::CompletionPriority);
+    data.setOllamaUrl(plugin_->getOllamaUrl());
+    data.setModel(model);
+    data.setPrompt(prefix);
+    data.setSuffix(suffix);
+    data.setOptions(options);
+    data.setKeepAlive(plugin_->getKeepAlive());
+
+    position_ = cursor;
+
+    // In speculative mode completions go through the speculator, which keeps finished ones for text the user returns to.
+    OllamaResponse speculativeResponse;
+    OllamaRequest *request = nullptr;
+    if (plugin_->isSpeculativeCompletionEnabled()) {
+        OllamaSpeculator *speculator = plugin_->getOllamaSpeculator();
+        if (!speculator->take(data, &speculativeResponse, &request)) {
+            speculator->speculate(data);
+            speculator->take(data, &speculativeResponse, &request);
+        }
+        if (!request) {
+            setSuggestion(speculativeResponse.getResponseText().trimmed().isEmpty() ? QString() : speculativeResponse.getResponseText());
+            return;
+        }
+    } else {
+        request = ollamaSystem_->ollamaRequest(data);
+    }
+
+    requestId_ = request->getId();
+    setSuggestion(speculativeResponse.getResponseText());
+    if (suggestion_.isEmpty()) {
+        latencyTimer_.start();
+    }
+
+    connect(request, &OllamaRequest::signal_gotResponse, this, &InlineCompletion::handle_ollamaRequestGotResponse);
+    connect(request, &OllamaRequest::signal_finished, this, &InlineCompletion::handle_ollamaRequestFinished);
+}
+
+void InlineCompletion::handle_ollamaRequestGotResponse(OllamaResponse ollamaResponse)
+{
+    if (ollamaResponse.getRequestId() != requestId_) {
+        return;
+    }
+    latencyTimer_.stop();
+    setSuggestion(suggestion_ + ollamaResponse.getResponseText());
+}
+
+void InlineCompletion::handle_ollamaRequestFinished(OllamaResponse ollamaResponse)
+{
+    if (ollamaResponse.getRequestId() != requestId_) {
+        return;
+    }
+    requestId_ = 0;
+    latencyTimer_.stop();
+
+    // A failed completion just does not show, errors are for the explicit actions to report.
+    if (ollamaResponse.getErrorType() != OllamaResponse::NoError) {
+        setSuggestion(QString());
+    } else {
+        setSuggestion(suggestion_.trimmed().isEmpty() ? QString() : suggestion_);
+    }
+}
+
+void InlineCompletion::cancelRequest()
+{
+    latencyTimer_.stop();
+    if (requestId_ != 0) {
+        // Cancelling finishes the request synchronously, clearing the id first makes that finish ignored.
+        quint64 requestId = requestId_;
+        requestId_ = 0;
+        ollamaSystem_->cancelRequest(requestId);
+    }
+}
+
+void InlineCompletion::setSuggestion(const QString &suggestion)
+{
+    int line = position_.line();
+    bool changed = suggestion != suggestion_;
+
+    suggestion_ = suggestion;
+    // The position stays while a request for it runs, its first token arrives there.
+    if (suggestion_.isEmpty() && requestId_ == 0) {
+        position_ = KTextEditor::Cursor::invalid();
+    }
+    if (changed && line >= 0) {
+        emit inlineNotesChanged(line);
+    }
+}
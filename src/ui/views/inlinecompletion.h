@@ -0,0 +1,80 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+#ifndef INLINECOMPLETION_H
+#define INLINECOMPLETION_H
+
+#include <KTextEditor/Cursor>
+#include <KTextEditor/Document>
+#include <KTextEditor/InlineNote>
+#include <KTextEditor/InlineNoteProvider>
+#include <KTextEditor/View>
+
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+#include "src/ollama/ollamaresponse.h"
+
+class KateOllamaPlugin;
+class OllamaSystem;
+
+/*
+ * Fill-in-the-middle completion shown as ghost text at the cursor of a view.
+ * After a short typing pause the text before and after the cursor is sent as prompt and suffix,
+ * the streamed answer is painted as an inline note and Tab inserts it. Every keystroke cancels
+ * the running request, so only a completion for the current text is ever shown.
+ */
+class InlineCompletion : public KTextEditor::InlineNoteProvider
+{
+    Q_OBJECT
+
+public:
+    // Gets the inline completion of the view, it is created on first use and lives as long as the view.
+    static InlineCompletion *forView(KTextEditor::View *view, KateOllamaPlugin *plugin, OllamaSystem *ollamaSystem);
+    ~InlineCompletion() override;
+
+    QList<int> inlineNotes(int line) const override;
+    QSize inlineNoteSize(const KTextEditor::InlineNote &note) const override;
+    void paintInlineNote(const KTextEditor::InlineNote &note, QPainter &painter, Qt::LayoutDirection direction) const override;
+
+    // Inserts the shown completion at the cursor.
+    void accept();
+    // Hides the shown completion and cancels the request for it.
+    void dismiss();
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+    void handle_textChanged(KTextEditor::Document *document);
+    void handle_cursorPositionChanged(KTextEditor::View *view, const KTextEditor::Cursor &newPosition);
+    void handle_debounceTimeout();
+
+    void handle_ollamaRequestGotResponse(OllamaResponse ollamaResponse);
+    void handle_ollamaRequestFinished(OllamaResponse ollamaResponse);
+
+private:
+    InlineCompletion(KTextEditor::View *view, KateOllamaPlugin *plugin, OllamaSystem *ollamaSystem);
+
+    void cancelRequest();
+    void setSuggestion(const QString &suggestion);
+
+    QPointer<KTextEditor::View> view_;
+    KateOllamaPlugin *plugin_;
+    OllamaSystem *ollamaSystem_;
+
+    QTimer debounceTimer_;
+    // Cancels a request which did not produce its first token in time.
+    QTimer latencyTimer_;
+    quint64 requestId_ = 0;
+
+    KTextEditor::Cursor position_ = KTextEditor::Cursor::invalid();
+    QString suggestion_;
+    // Set while the completion is inserted, so that edit does not dismiss it.
+    bool accepting_ = false;
+};
+
+#endif // INLINECOMPLETION_H
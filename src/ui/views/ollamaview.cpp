@@ -41,14 +41,24 @@
 #include "src/ollama//ollamasystem.h"
 #include "src/ollama/ollamadata.h"
 #include "src/ollama/ollamaglobals.h"
+#include "src/ollama/ollamarequest.h"
 #include "src/ollama/ollamaresponse.h"
+#include "src/ollama/ollamaspeculator.h"
+#include "src/ollama/ollamatokenestimator.h"
 #include "src/plugin.h"
+#include "src/ui/utilities/contextbuilder.h"
+#include "src/ui/utilities/documentsink.h"
+#include "src/ui/utilities/markerindex.h"
 #include "src/ui/utilities/messages.h"
+#include "src/ui/views/inlinecompletion.h"
 #include "src/ui/views/ollamaview.h"
 #include "src/ui/widgets/toolwidget.h"
 
 using namespace Qt::Literals::StringLiterals;
 
+// Typing pause after which the prompt at the cursor is sent speculatively.
+static constexpr int IdleMs = 700;
+
 KateOllamaView::KateOllamaView(KateOllamaPlugin *plugin, KTextEditor::MainWindow *mainwindow, OllamaSystem *ollamaSystem)
     : KXMLGUIClient()
     , plugin_(plugin)
@@ -61,6 +71,35 @@ KateOllamaView::KateOllamaView(KateOllamaPlugin *plugin, KTextEditor::MainWindow
     plugin_->setModel(group.readEntry("Model"));
     plugin_->setSystemPrompt(group.readEntry("SystemPrompt"));
     plugin_->setOllamaUrl(group.readEntry("URL"));
+    plugin_->setInlineCompletionEnabled(group.readEntry("InlineCompletion", false));
+    plugin_->setInlineCompletionModel(group.readEntry("InlineCompletionModel"));
+    plugin_->setSpeculativeCompletionEnabled(group.readEntry("SpeculativeCompletion", false));
+    plugin_->setSeed(group.readEntry("Seed", 0));
+    plugin_->setKeepAlive(group.readEntry("KeepAlive", "30m"));
+
+    ollamaSystem_->setMaxParallelRequests(group.readEntry("MaxParallelRequests", 1));
+    ollamaSystem_->setEndpoints(QStringList{plugin_->getOllamaUrl()} + group.readEntry("Endpoints", QStringList()));
+    ollamaSystem_->setHedgePercentile(group.readEntry("HedgePercentile", 0));
+    ollamaSystem_->setConnectTimeout(group.readEntry("ConnectTimeout", 5) * 1000);
+    ollamaSystem_->setFirstTokenTimeout(group.readEntry("FirstTokenTimeout", 90) * 1000);
+    ollamaSystem_->setStallTimeout(group.readEntry("StallTimeout", 20) * 1000);
+    ollamaSystem_->setResponseCacheEnabled(group.readEntry("ResponseCache", true));
+    ollamaSystem_->setSemanticCacheEnabled(group.readEntry("SemanticCache", false));
+    ollamaSystem_->setEmbeddingModel(group.readEntry("EmbeddingModel", "nomic-embed-text"));
+    ollamaSystem_->setSemanticCacheThreshold(group.readEntry("SemanticCacheThreshold", 0.92));
+    ollamaSystem_->preconnect(plugin_->getOllamaUrl());
+
+    // Load the model while Kate starts, so the first prompt streams right away.
+    OllamaData modelData;
+    modelData.setOllamaUrl(plugin_->getOllamaUrl());
+    modelData.setModel(plugin_->getModel());
+    modelData.setKeepAlive(plugin_->getKeepAlive());
+    ollamaSystem_->fetchModelInfo(modelData);
+    ollamaSystem_->preloadModel(modelData);
+    if (plugin_->isInlineCompletionEnabled() && !plugin_->getInlineCompletionModel().isEmpty()) {
+        modelData.setModel(plugin_->getInlineCompletionModel());
+        ollamaSystem_->preloadModel(modelData);
+    }
 
     auto ac = actionCollection();
     QAction *a = ac->addAction(QStringLiteral("kateollama"));
@@ -80,6 +119,33 @@ KateOllamaView::KateOllamaView(KateOllamaPlugin *plugin, KTextEditor::MainWindow
     KActionCollection::setDefaultShortcut(a3, QKeySequence((Qt::CTRL | Qt::Key_Slash)));
     connect(a3, &QAction::triggered, this, &KateOllamaView::handle_onPrintCommand);
 
+    // Only enabled while a request runs, so Escape keeps its usual meaning otherwise.
+    stopAction_ = ac->addAction(QStringLiteral("kateollama-stop"));
+    stopAction_->setText(i18n("Stop Ollama"));
+    stopAction_->setIcon(QIcon::fromTheme(QStringLiteral("process-stop")));
+    stopAction_->setEnabled(false);
+    KActionCollection::setDefaultShortcut(stopAction_, QKeySequence(Qt::Key_Escape));
+    connect(stopAction_, &QAction::triggered, this, &KateOllamaView::handle_onStop);
+
+    inlineCompletionAction_ = ac->addAction(QStringLiteral("kateollama-inline-completion"));
+    inlineCompletionAction_->setText(i18n("Ollama Inline Completion"));
+    inlineCompletionAction_->setCheckable(true);
+    inlineCompletionAction_->setChecked(plugin_->isInlineCompletionEnabled());
+    connect(inlineCompletionAction_, &QAction::toggled, this, &KateOllamaView::handle_onToggleInlineCompletion);
+
+    speculativeCompletionAction_ = ac->addAction(QStringLiteral("kateollama-speculative-completion"));
+    speculativeCompletionAction_->setText(i18n("Ollama Speculative Completion"));
+    speculativeCompletionAction_->setCheckable(true);
+    speculativeCompletionAction_->setChecked(plugin_->isSpeculativeCompletionEnabled());
+    connect(speculativeCompletionAction_, &QAction::toggled, this, &KateOllamaView::handle_onToggleSpeculativeCompletion);
+
+    idleTimer_.setSingleShot(true);
+    idleTimer_.setInterval(IdleMs);
+    connect(&idleTimer_, &QTimer::timeout, this, &KateOllamaView::handle_idleTimeout);
+
+    connect(mainWindow_, &KTextEditor::MainWindow::viewChanged, this, &KateOllamaView::handle_viewChanged);
+    handle_viewChanged(mainWindow_->activeView());
+
     mainWindow_->guiFactory()->addClient(this);
 
     auto toolview = mainWindow_->createToolView(plugin,
@@ -91,12 +157,6 @@ KateOllamaView::KateOllamaView(KateOllamaPlugin *plugin, KTextEditor::MainWindow
     toolWidget_ = new OllamaToolWidget(plugin_, mainWindow_, ollamaSystem_, toolview);
 
     toolview_.reset(toolview);
-
-    connect(ollamaSystem_, &OllamaSystem::signal_ollamaRequestMetaDataChanged, this, &KateOllamaView::handle_ollamaRequestMetaDataChanged);
-
-    connect(ollamaSystem_, &OllamaSystem::signal_ollamaRequestGotResponse, this, &KateOllamaView::handle_ollamaRequestGotResponse);
-
-    connect(ollamaSystem_, &OllamaSystem::signal_ollamaRequestFinished, this, &KateOllamaView::handle_ollamaRequestFinished);
 }
 
 KateOllamaView::~KateOllamaView()
@@ -123,13 +183,27 @@ void KateOllamaView::handle_onSinglePrompt()
 void KateOllamaView::handle_onFullPrompt()
 {
     KTextEditor::View *view = mainWindow_->activeView();
-    KTextEditor::Document *document = view->document();
-    QString text = document->text();
     if (view) {
-        QString prompt = KateOllamaView::getPrompt();
+        int markerLine = -1;
+        QString prompt = KateOllamaView::getPrompt(&markerLine);
         if (!prompt.isEmpty()) {
             Messages::showStatusMessage(QStringLiteral("Info: Full prompt..."), KTextEditor::Message::Information, mainWindow_);
+
+            // Send as much of the document as fits in the model's context window, leaving a quarter for the answer.
+            // The window is fetched once per model, until then a conservative default is used.
+            OllamaData modelData;
+            modelData.setOllamaUrl(plugin_->getOllamaUrl());
+            modelData.setModel(plugin_->getModel());
+            ollamaSystem_->fetchModelInfo(modelData);
+
+            int contextLength = ollamaSystem_->getContextLength(plugin_->getOllamaUrl(), plugin_->getModel());
+            int tokenBudget = contextLength * 3 / 4 - OllamaTokenEstimator::estimateTokens(plugin_->getSystemPrompt())
+                - OllamaTokenEstimator::estimateTokens(prompt);
+            QString text = ContextBuilder::build(view->document(), markerLine, view->cursorPosition().line(), tokenBudget);
+
             KateOllamaView::ollamaRequest(text + "\n" + prompt);
+            // The marker's own prompt counts as answered too.
+            answeredKey_ = createRequestData(prompt).getCacheKey();
         } else {
             Messages::showStatusMessage(QStringLiteral("Info: No full prompt..."), KTextEditor::Message::Information, mainWindow_);
         }
@@ -151,33 +225,123 @@ void KateOllamaView::handle_onPrintCommand()
     }
 }
 
-void KateOllamaView::handle_ollamaRequestMetaDataChanged(OllamaResponse ollamaResponse)
+void KateOllamaView::handle_onStop()
 {
-    if (ollamaResponse.getReceiver() == "editor" || ollamaResponse.getReceiver() == "") {
-        KTextEditor::View *view = mainWindow_->activeView();
-        KTextEditor::Document *document = view->document();
-        KTextEditor::Cursor cursor = view->cursorPosition();
-        document->insertText(cursor, "\n");
-        Messages::showStatusMessage(QStringLiteral("Info: Request started..."), KTextEditor::Message::Information, mainWindow_);
+    // Cancelling finishes the request synchronously, which removes it from sinks_.
+    const QList<quint64> requestIds = sinks_.keys();
+    for (quint64 requestId : requestIds) {
+        ollamaSystem_->cancelRequest(requestId);
     }
 }
 
-void KateOllamaView::handle_ollamaRequestGotResponse(OllamaResponse ollamaResponse)
+void KateOllamaView::handle_onToggleInlineCompletion(bool enabled)
 {
-    if (ollamaResponse.getReceiver() != "editor" && ollamaResponse.getReceiver() != "")
+    plugin_->setInlineCompletionEnabled(enabled);
+
+    KConfigGroup group(KSharedConfig::openConfig(), "KateOllama");
+    group.writeEntry("InlineCompletion", enabled);
+    group.sync();
+
+    if (!enabled) {
+        const QList<KTextEditor::View *> views = mainWindow_->views();
+        for (KTextEditor::View *view : views) {
+            if (InlineCompletion *inlineCompletion = view->findChild<InlineCompletion *>(QString(), Qt::FindDirectChildrenOnly)) {
+                inlineCompletion->dismiss();
+            }
+        }
+    }
+}
+
+void KateOllamaView::handle_onToggleSpeculativeCompletion(bool enabled)
+{
+    plugin_->setSpeculativeCompletionEnabled(enabled);
+
+    KConfigGroup group(KSharedConfig::openConfig(), "KateOllama");
+    group.writeEntry("SpeculativeCompletion", enabled);
+    group.sync();
+
+    if (!enabled) {
+        idleTimer_.stop();
+        plugin_->getOllamaSpeculator()->cancelRunning();
+    }
+}
+
+void KateOllamaView::handle_viewChanged(KTextEditor::View *view)
+{
+    idleTimer_.stop();
+    if (document_) {
+        disconnect(document_, &KTextEditor::Document::textChanged, this, &KateOllamaView::handle_textChanged);
+    }
+    document_ = view ? view->document() : nullptr;
+
+    // Views only get ghost text once they have been active, which is when typing in them starts.
+    if (view) {
+        InlineCompletion::forView(view, plugin_, ollamaSystem_);
+        connect(document_, &KTextEditor::Document::textChanged, this, &KateOllamaView::handle_textChanged);
+    }
+}
+
+void KateOllamaView::handle_textChanged(KTextEditor::Document *document)
+{
+    Q_UNUSED(document);
+
+    // Answers written by the plugin are not typing.
+    if (!plugin_->isSpeculativeCompletionEnabled() || DocumentSink::isWriting()) {
         return;
+    }
+
+    // Typing resumed, so whatever was guessed during the last pause is moot.
+    plugin_->getOllamaSpeculator()->cancelRunning();
+    idleTimer_.start();
+}
 
+void KateOllamaView::handle_idleTimeout()
+{
     KTextEditor::View *view = mainWindow_->activeView();
-    KTextEditor::Document *document = view->document();
-    KTextEditor::Cursor cursor = view->cursorPosition();
-    document->insertText(cursor, ollamaResponse.getResponseText());
-    Messages::showStatusMessage(QStringLiteral("Info: Reply received..."), KTextEditor::Message::Information, mainWindow_);
+    if (!view || view->document() != document_) {
+        return;
+    }
+
+    // The same prompt "Run Ollama" would send, so pressing it shows the answer at once.
+    MarkerIndex *markerIndex = MarkerIndex::forDocument(view->document());
+    int line = markerIndex->findNearestMarker(view->cursorPosition().line());
+    if (line == -1) {
+        return;
+    }
+
+    QString prompt = markerIndex->getPrompt(line);
+    if (prompt.isEmpty()) {
+        return;
+    }
+
+    // A prompt which was just answered is not asked again.
+    OllamaData data = createRequestData(prompt);
+    if (data.getCacheKey() != answeredKey_) {
+        plugin_->getOllamaSpeculator()->speculate(data);
+    }
+}
+
+void KateOllamaView::handle_ollamaRequestMetaDataChanged(OllamaResponse ollamaResponse)
+{
+    if (DocumentSink *sink = sinks_.value(ollamaResponse.getRequestId())) {
+        sink->append("\n");
+    }
+    Messages::showStatusMessage(QStringLiteral("Info: Request started..."), KTextEditor::Message::Information, mainWindow_);
+}
+
+void KateOllamaView::handle_ollamaRequestGotResponse(OllamaResponse ollamaResponse)
+{
+    if (DocumentSink *sink = sinks_.value(ollamaResponse.getRequestId())) {
+        sink->append(ollamaResponse.getResponseText());
+    }
 }
 
 void KateOllamaView::handle_ollamaRequestFinished(OllamaResponse ollamaResponse)
 {
-    if (ollamaResponse.getErrorMessage() != QString("")) {
-        Messages::showStatusMessage(QStringLiteral("Error encountered: ").arg(ollamaResponse.getErrorMessage()),
+    if (ollamaResponse.getErrorType() == OllamaResponse::CancelledError) {
+        Messages::showStatusMessage(QStringLiteral("Info: Request cancelled..."), KTextEditor::Message::Information, mainWindow_);
+    } else if (ollamaResponse.getErrorMessage() != QString("")) {
+        Messages::showStatusMessage(QStringLiteral("Error encountered: %1").arg(ollamaResponse.getErrorMessage()),
                                     KTextEditor::Message::Information,
                                     mainWindow_);
         qDebug() << "Error:" << ollamaResponse.getErrorMessage();
@@ -185,35 +349,39 @@ void KateOllamaView::handle_ollamaRequestFinished(OllamaResponse ollamaResponse)
         qDebug() << "System prompt:" << plugin_->getSystemPrompt();
     }
 
-    if (ollamaResponse.getReceiver() == "editor" || ollamaResponse.getReceiver() == "") {
-        KTextEditor::View *view = mainWindow_->activeView();
-        KTextEditor::Document *document = view->document();
-        KTextEditor::Cursor cursor = view->cursorPosition();
-        document->insertText(cursor, "\n");
+    // Whatever arrived before a cancel stays in the document, terminated like a complete response.
+    if (DocumentSink *sink = sinks_.take(ollamaResponse.getRequestId())) {
+        sink->append("\n");
+        sink->finish();
+        sink->deleteLater();
     }
+    stopAction_->setEnabled(!sinks_.isEmpty());
 }
 
-QString KateOllamaView::getPrompt()
+QString KateOllamaView::getPrompt(int *markerLine)
 {
     Messages::showStatusMessage(QStringLiteral("Info: Getting prompt..."), KTextEditor::Message::Information, mainWindow_);
     KTextEditor::View *view = mainWindow_->activeView();
-    KTextEditor::Document *document = view->document();
-    QString text = document->text();
+    MarkerIndex *markerIndex = MarkerIndex::forDocument(view->document());
 
-    QString lastMatch = ollamaSystem_->getPromptFromText(text);
+    int line = markerIndex->findNearestMarker(view->cursorPosition().line());
+    if (markerLine) {
+        *markerLine = line;
+    }
+    if (line == -1) {
+        return QString();
+    }
 
-    return lastMatch;
+    return markerIndex->getPrompt(line);
 }
 
-void KateOllamaView::ollamaRequest(QString prompt)
+OllamaData KateOllamaView::createRequestData(const QString &prompt)
 {
-    Messages::showStatusMessage(QStringLiteral("Info: Setting up request..."), KTextEditor::Message::Information, mainWindow_);
-
-    QJsonObject json_data;
     OllamaData data;
     QVector<QString> images;
 
     data.setSender("editor");
+    data.setPriority(OllamaData::InteractivePriority);
     data.setOllamaUrl(plugin_->getOllamaUrl());
     data.setModel(plugin_->getModel());
     data.setPrompt(prompt);
@@ -224,14 +392,58 @@ void KateOllamaView::ollamaRequest(QString prompt)
     }
 
     // data.setFormat("");
-    // data.setOptions("");
+    // A fixed seed makes answers reproducible, which lets OllamaSystem cache them.
+    if (plugin_->getSeed() != 0) {
+        data.setOptions(QJsonObject{{"seed", plugin_->getSeed()}});
+    }
     data.setSystemPrompt(plugin_->getSystemPrompt());
+    data.setKeepAlive(plugin_->getKeepAlive());
     // data.setContext("");
     // data.setStream("");
 
-    json_data = data.toJson();
+    return data;
+}
 
-    QJsonDocument doc(json_data);
+void KateOllamaView::ollamaRequest(QString prompt)
+{
+    Messages::showStatusMessage(QStringLiteral("Info: Setting up request..."), KTextEditor::Message::Information, mainWindow_);
+
+    OllamaData data = createRequestData(prompt);
+    answeredKey_ = data.getCacheKey();
 
-    ollamaSystem_->ollamaRequest(data);
+    KTextEditor::View *view = mainWindow_->activeView();
+    if (!view) {
+        return;
+    }
+
+    // A speculative answer for the same prompt is shown as far as it got, instead of starting over.
+    OllamaResponse speculativeResponse;
+    OllamaRequest *request = nullptr;
+    bool speculated = plugin_->getOllamaSpeculator()->take(data, &speculativeResponse, &request);
+
+    if (speculated && !request) {
+        DocumentSink *sink = new DocumentSink(view->document(), view->cursorPosition(), this);
+        sink->append("\n" + speculativeResponse.getResponseText() + "\n");
+        sink->finish();
+        sink->deleteLater();
+        return;
+    }
+
+    if (!speculated) {
+        request = ollamaSystem_->ollamaRequest(data);
+    }
+
+    // The response goes where the request was made, even when another view is activated meanwhile.
+    DocumentSink *sink = new DocumentSink(view->document(), view->cursorPosition(), this);
+    sinks_.insert(request->getId(), sink);
+    stopAction_->setEnabled(true);
+
+    if (speculated) {
+        // The speculation already started, its metadata signal was emitted before it was taken over.
+        sink->append("\n" + speculativeResponse.getResponseText());
+    } else {
+        connect(request, &OllamaRequest::signal_metaDataChanged, this, &KateOllamaView::handle_ollamaRequestMetaDataChanged);
+    }
+    connect(request, &OllamaRequest::signal_gotResponse, this, &KateOllamaView::handle_ollamaRequestGotResponse);
+    connect(request, &OllamaRequest::signal_finished, this, &KateOllamaView::handle_ollamaRequestFinished);
 }
@@ -9,13 +9,19 @@
 #include <KTextEditor/Plugin>
 
 #include <KXMLGUIClient>
+#include <QByteArray>
+#include <QHash>
 #include <QObject>
+#include <QPointer>
+#include <QTimer>
 
 #include "src/ollama/ollamaresponse.h"
 #include "src/ollama/ollamasystem.h"
 #include "src/ui/widgets/toolwidget.h"
 
 class KateOllamaPlugin;
+class QAction;
+class DocumentSink;
 
 class KateOllamaView : public QObject, public KXMLGUIClient
 {
@@ -30,21 +36,42 @@ private slots:
     void handle_onSinglePrompt();
     void handle_onFullPrompt();
     void handle_onPrintCommand();
+    void handle_onStop();
+    void handle_onToggleInlineCompletion(bool enabled);
+    void handle_onToggleSpeculativeCompletion(bool enabled);
+    void handle_viewChanged(KTextEditor::View *view);
+    void handle_textChanged(KTextEditor::Document *document);
+    void handle_idleTimeout();
 
     void handle_ollamaRequestMetaDataChanged(OllamaResponse ollamaResponse);
     void handle_ollamaRequestGotResponse(OllamaResponse ollamaResponse);
     void handle_ollamaRequestFinished(OllamaResponse ollamaResponse);
 
 private:
-    QString getPrompt();
+    // Gets the prompt of the "// AI:" marker nearest to the cursor, and optionally the line it is on.
+    QString getPrompt(int *markerLine = nullptr);
+    // Creates the request the "Run Ollama" actions make for the prompt.
+    OllamaData createRequestData(const QString &prompt);
     void ollamaRequest(QString prompt);
 
 private:
     KateOllamaPlugin *plugin_ = nullptr;
     KTextEditor::MainWindow *mainWindow_ = nullptr;
     OllamaToolWidget *toolWidget_ = nullptr;
+    QAction *stopAction_ = nullptr;
+    QAction *inlineCompletionAction_ = nullptr;
+    QAction *speculativeCompletionAction_ = nullptr;
     std::unique_ptr<QWidget> toolview_;
     OllamaSystem *ollamaSystem_;
+    // Where the response of each running request is written, by request id.
+    QHash<quint64, DocumentSink *> sinks_;
+    // The document of the active view, whose typing pauses start speculative requests.
+    QPointer<KTextEditor::Document> document_;
+    QTimer idleTimer_;
+    // Cache key of the last request "Run Ollama" made, its prompt is not speculated on again.
+    QByteArray answeredKey_;
+    // Cache key of the last request "Run Ollama" made, its prompt is not speculated on again.
+    QByteArray answeredKey_;
 };
 
 #endif // KATEOLLAMAVIEW_H
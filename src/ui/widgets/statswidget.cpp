@@ -0,0 +1,157 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+#include <KLocalizedString>
+
+#include <QHeaderView>
+#include <QLabel>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+#include "src/ollama/ollamasystem.h"
+#include "src/ui/widgets/statswidget.h"
+
+// How many requests of a model the rolling numbers are taken over.
+static const qsizetype MaxSamplesPerModel = 20;
+
+enum ModelColumn {
+    ModelNameColumn,
+    RequestsColumn,
+    FirstTokenColumn,
+    LatencyColumn,
+    LoadColumn,
+    PromptEvalColumn,
+    GenerationColumn,
+    ColumnCount
+};
+
+OllamaStatsWidget::OllamaStatsWidget(OllamaSystem *ollamaSystem, QWidget *parent)
+    : QWidget(parent)
+    , ollamaSystem_(ollamaSystem)
+{
+    QVBoxLayout *layout = new QVBoxLayout(this);
+
+    lastRequestLabel_ = new QLabel(i18n("No request finished yet."), this);
+    lastRequestLabel_->setWordWrap(true);
+    lastRequestLabel_->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    layout->addWidget(lastRequestLabel_);
+
+    modelsTree_ = new QTreeWidget(this);
+    modelsTree_->setColumnCount(ColumnCount);
+    modelsTree_->setHeaderLabels({i18n("Model"),
+                                  i18n("Requests"),
+                                  i18n("First token"),
+                                  i18n("Latency"),
+                                  i18n("Load"),
+                                  i18n("Prompt eval"),
+                                  i18n("Generation")});
+    modelsTree_->setRootIsDecorated(false);
+    modelsTree_->setSortingEnabled(true);
+    modelsTree_->sortByColumn(ModelNameColumn, Qt::AscendingOrder);
+    modelsTree_->header()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    modelsTree_->setToolTip(i18n("Averages over the last %1 requests of each model", MaxSamplesPerModel));
+    layout->addWidget(modelsTree_);
+
+    connect(ollamaSystem_, &OllamaSystem::signal_requestStatistics, this, &OllamaStatsWidget::handle_signalRequestStatistics);
+}
+
+OllamaStatsWidget::~OllamaStatsWidget()
+{
+}
+
+void OllamaStatsWidget::handle_signalRequestStatistics(const QString &model, OllamaResponse ollamaResponse)
+{
+    Sample sample;
+    sample.timeToFirstTokenMs = ollamaResponse.getTimeToFirstToken();
+    sample.latencyMs = ollamaResponse.getLatency();
+    sample.loadMs = ollamaResponse.getLoadDuration() / 1000000;
+    sample.promptEvalCount = ollamaResponse.getPromptEvalCount();
+    sample.promptEvalMs = ollamaResponse.getPromptEvalDuration() / 1000000;
+    sample.evalCount = ollamaResponse.getEvalCount();
+    sample.evalMs = ollamaResponse.getEvalDuration() / 1000000;
+    // Replayed answers carry no timings of Ollama.
+    sample.cached = ollamaResponse.getTotalDuration() == 0;
+
+    QString firstToken = sample.timeToFirstTokenMs >= 0 ? i18n("%1 ms", sample.timeToFirstTokenMs) : i18n("none");
+    if (sample.cached) {
+        lastRequestLabel_->setText(i18n("Last request (%1): answered from the cache, first token %2, latency %3 ms.", model, firstToken, sample.latencyMs));
+    } else {
+        lastRequestLabel_->setText(i18n("Last request (%1): first token %2, latency %3 ms. Load %4 ms, prompt eval %5 tokens in %6 ms (%7), "
+                                        "generation %8 tokens in %9 ms (%10).",
+                                        model,
+                                        firstToken,
+                                        sample.latencyMs,
+                                        sample.loadMs,
+                                        sample.promptEvalCount,
+                                        sample.promptEvalMs,
+                                        formatTokensPerSecond(sample.promptEvalCount, sample.promptEvalMs),
+                                        sample.evalCount,
+                                        sample.evalMs,
+                                        formatTokensPerSecond(sample.evalCount, sample.evalMs)));
+    }
+
+    QList<Sample> &samples = samples_[model];
+    samples.append(sample);
+    if (samples.size() > MaxSamplesPerModel) {
+        samples.removeFirst();
+    }
+    updateModelRow(model);
+}
+
+void OllamaStatsWidget::updateModelRow(const QString &model)
+{
+    const QList<Sample> &samples = samples_[model];
+
+    qint64 firstTokenMs = 0;
+    qint64 firstTokenCount = 0;
+    qint64 latencyMs = 0;
+    qint64 loadMs = 0;
+    qint64 promptEvalCount = 0;
+    qint64 promptEvalMs = 0;
+    qint64 evalCount = 0;
+    qint64 evalMs = 0;
+    qint64 generatedCount = 0;
+    for (const Sample &sample : samples) {
+        // Replayed answers took no time on the server, they would hide its real latency.
+        if (!sample.cached) {
+            if (sample.timeToFirstTokenMs >= 0) {
+                firstTokenMs += sample.timeToFirstTokenMs;
+                ++firstTokenCount;
+            }
+            latencyMs += sample.latencyMs;
+            loadMs += sample.loadMs;
+            promptEvalCount += sample.promptEvalCount;
+            promptEvalMs += sample.promptEvalMs;
+            evalCount += sample.evalCount;
+            evalMs += sample.evalMs;
+            ++generatedCount;
+        }
+    }
+
+    QTreeWidgetItem *item = nullptr;
+    const QList<QTreeWidgetItem *> items = modelsTree_->findItems(model, Qt::MatchExactly, ModelNameColumn);
+    if (items.isEmpty()) {
+        item = new QTreeWidgetItem(modelsTree_);
+        item->setText(ModelNameColumn, model);
+    } else {
+        item = items.first();
+    }
+
+    // Token rates are summed over the requests, so long answers weigh in like they do for the user.
+    item->setText(RequestsColumn, QString::number(samples.size()));
+    item->setText(FirstTokenColumn, firstTokenCount > 0 ? i18n("%1 ms", firstTokenMs / firstTokenCount) : QString());
+    item->setText(LatencyColumn, generatedCount > 0 ? i18n("%1 ms", latencyMs / generatedCount) : QString());
+    item->setText(LoadColumn, generatedCount > 0 ? i18n("%1 ms", loadMs / generatedCount) : QString());
+    item->setText(PromptEvalColumn, formatTokensPerSecond(promptEvalCount, promptEvalMs));
+    item->setText(GenerationColumn, formatTokensPerSecond(evalCount, evalMs));
+}
+
+QString OllamaStatsWidget::formatTokensPerSecond(qint64 tokens, qint64 ms)
+{
+    if (tokens <= 0 || ms <= 0) {
+        return QString();
+    }
+    return i18n("%1 tokens/s", QString::number(double(tokens) * 1000.0 / double(ms), 'f', 1));
+}
@@ -0,0 +1,58 @@
+/*
+ *  SPDX-FileCopyrightText: 2025 tfks <development@worloflinux.nl>
+ *
+ *  SPDX-License-Identifier: LGPL-2.0-or-later
+ */
+#ifndef OLLAMASTATSWIDGET_HEADER_H
+#define OLLAMASTATSWIDGET_HEADER_H
+
+#include <QHash>
+#include <QList>
+#include <QWidget>
+
+#include "src/ollama/ollamaresponse.h"
+
+class OllamaSystem;
+class QLabel;
+class QTreeWidget;
+
+/*
+ * Shows where the time of requests went: the last request in detail and a rolling average per model.
+ * Time to first token and latency are measured by the plugin, load, prompt evaluation and generation
+ * come from the final record of Ollama's stream.
+ */
+class OllamaStatsWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit OllamaStatsWidget(OllamaSystem *ollamaSystem, QWidget *parent = nullptr);
+    virtual ~OllamaStatsWidget();
+
+private slots:
+    void handle_signalRequestStatistics(const QString &model, OllamaResponse ollamaResponse);
+
+private:
+    // The numbers of one request, in milliseconds and tokens.
+    struct Sample {
+        qint64 timeToFirstTokenMs = -1;
+        qint64 latencyMs = 0;
+        qint64 loadMs = 0;
+        qint64 promptEvalCount = 0;
+        qint64 promptEvalMs = 0;
+        qint64 evalCount = 0;
+        qint64 evalMs = 0;
+        bool cached = false;
+    };
+
+    void updateModelRow(const QString &model);
+    static QString formatTokensPerSecond(qint64 tokens, qint64 ms);
+
+    OllamaSystem *ollamaSystem_;
+    QLabel *lastRequestLabel_;
+    QTreeWidget *modelsTree_;
+    // The most recent samples of every model, oldest first.
+    QHash<QString, QList<Sample>> samples_;
+};
+
+#endif // OLLAMASTATSWIDGET_HEADER_H
@@ -12,10 +12,12 @@
 #include <QHBoxLayout>
 #include <QIcon>
 #include <QObject>
+#include <QTabBar>
 #include <QVBoxLayout>
 
 #include "src/ollama/ollamaglobals.h"
 #include "src/ui/tabs/maintab.h"
+#include "src/ui/widgets/statswidget.h"
 #include "src/ui/widgets/toolwidget.h"
 
 OllamaToolWidget::OllamaToolWidget(KateOllamaPlugin *plugin, KTextEditor::MainWindow *mainWindow, OllamaSystem *ollamaSystem, QWidget *parent)
@@ -31,7 +33,14 @@ OllamaToolWidget::OllamaToolWidget(KateOllamaPlugin *plugin, KTextEditor::MainWi
     tabWidget_.addTab(new MainTab(plugin_, mainWindow, ollamaSystem_, this), OllamaGlobals::PluginName);
     tabWidget_.setTabsClosable(true);
 
+    statsWidget_ = new OllamaStatsWidget(ollamaSystem_, this);
+    int statsIndex = tabWidget_.addTab(statsWidget_, QIcon::fromTheme(QStringLiteral("view-statistics")), i18n("Performance"));
+    tabWidget_.tabBar()->setTabButton(statsIndex, QTabBar::RightSide, nullptr);
+
     connect(&tabWidget_, &QTabWidget::tabCloseRequested, this, [this](int idx) {
+        if (tabWidget_.widget(idx) == statsWidget_) {
+            return;
+        }
         if (auto w = tabWidget_.widget(idx)) {
             w->deleteLater();
         }
@@ -45,7 +54,8 @@ OllamaToolWidget::~OllamaToolWidget()
 
 void OllamaToolWidget::newTab()
 {
-    int index = tabWidget_.count() + 1;
+    // The performance tab is not counted.
+    int index = tabWidget_.count();
 
     QString tabName = QString(OllamaGlobals::PluginName).append(" (").append(QString::number(index)).append(")");
 
@@ -15,6 +15,8 @@
 #include "src/ollama/ollamasystem.h"
 #include "src/plugin.h"
 
+class OllamaStatsWidget;
+
 class OllamaToolWidget : public QWidget
 {
     Q_OBJECT
@@ -34,5 +36,7 @@ private:
     KTextEditor::MainWindow *mainWindow_ = nullptr;
     QTabWidget tabWidget_;
     OllamaSystem *ollamaSystem_;
+    // Always open, next to the first tab.
+    OllamaStatsWidget *statsWidget_ = nullptr;
 };
 #endif // OLLAMATOOLWIDGET_HEADER_H